@@ -0,0 +1,292 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+// Headless benchmark of the layout and filtering pipeline. Prints one
+// tab-separated row per case so releases can be diffed mechanically.
+
+#include "client.h"
+#include "layout.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MIN_NS 50000000ULL
+
+static unsigned long bench_allocs;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  bench_allocs++;
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+  bench_allocs++;
+  return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+  bench_allocs++;
+  return __real_realloc(ptr, size);
+}
+
+typedef struct {
+  gf_layout_params params;
+  gf_client_table table;
+  gf_workspace_snapshot snapshot;
+  gf_layout_plan plan;
+  gf_layout_plan reference;
+  gf_layout_tree tree;
+  int *leaves; // leaf of each window in `tree`
+  gf_rect area;
+  unsigned long count;
+  int workspaces;
+  unsigned long cursor;
+} bench_ctx;
+
+// Each case returns the number of X requests the op would have issued
+typedef unsigned long (*bench_func)(bench_ctx *ctx);
+
+static unsigned long long bench_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void bench_run(const char *name, bench_func func, bench_ctx *ctx) {
+  unsigned long long iterations = 1, elapsed = 0;
+  unsigned long allocs = 0, requests = 0;
+
+  while (1) {
+    allocs = bench_allocs;
+    requests = 0;
+    unsigned long long start = bench_now_ns();
+    for (unsigned long long i = 0; i < iterations; i++)
+      requests += func(ctx);
+    elapsed = bench_now_ns() - start;
+    allocs = bench_allocs - allocs;
+
+    if (elapsed >= BENCH_MIN_NS || iterations >= (1ULL << 40))
+      break;
+    iterations *= 2;
+  }
+
+  printf("%s\t%lu\t%d\t%llu\t%.2f\t%.4f\t%.4f\n", name, ctx->count,
+         ctx->workspaces, iterations, (double)elapsed / iterations,
+         (double)allocs / iterations, (double)requests / iterations);
+}
+
+static unsigned long bench_layout(bench_ctx *ctx) {
+  gf_layout_compute(&ctx->params, ctx->count, ctx->area, NULL,
+                    ctx->plan.rects);
+  return 0;
+}
+
+static unsigned long bench_layout_hinted(bench_ctx *ctx) {
+  gf_layout_compute(&ctx->params, ctx->count, ctx->area, ctx->table.hints,
+                    ctx->plan.rects);
+  return 0;
+}
+
+static unsigned long bench_filter(bench_ctx *ctx) {
+  gf_client_table_filter(&ctx->table, ctx->cursor++ % ctx->workspaces,
+                         ctx->plan.windows);
+  return 0;
+}
+
+static unsigned long bench_bucket(bench_ctx *ctx) {
+  gf_workspace_snapshot_build(&ctx->snapshot, &ctx->table, ctx->workspaces);
+  return 0;
+}
+
+static void bench_reload_plan(bench_ctx *ctx) {
+  memcpy(ctx->plan.windows, ctx->reference.windows,
+         ctx->reference.count * sizeof(Window));
+  memcpy(ctx->plan.rects, ctx->reference.rects,
+         ctx->reference.count * sizeof(gf_rect));
+  ctx->plan.count = ctx->reference.count;
+}
+
+static unsigned long bench_commit_unchanged(bench_ctx *ctx) {
+  bench_reload_plan(ctx);
+  return gf_client_table_diff(&ctx->table, &ctx->plan);
+}
+
+static unsigned long bench_commit_one(bench_ctx *ctx) {
+  gf_client_table_invalidate(&ctx->table, ctx->cursor++ % ctx->count);
+  bench_reload_plan(ctx);
+  return gf_client_table_diff(&ctx->table, &ctx->plan);
+}
+
+// One window closes and reopens, laid out from the flat window list
+static unsigned long bench_lifecycle_flat(bench_ctx *ctx) {
+  unsigned long gone = ctx->cursor++ % ctx->count, requests;
+
+  memcpy(ctx->plan.windows, ctx->reference.windows, gone * sizeof(Window));
+  memcpy(ctx->plan.windows + gone, ctx->reference.windows + gone + 1,
+         (ctx->count - gone - 1) * sizeof(Window));
+  ctx->plan.count = ctx->count - 1;
+  gf_layout_compute(&ctx->params, ctx->plan.count, ctx->area, NULL,
+                    ctx->plan.rects);
+  requests = gf_client_table_diff(&ctx->table, &ctx->plan);
+
+  bench_reload_plan(ctx);
+  return requests + gf_client_table_diff(&ctx->table, &ctx->plan);
+}
+
+// The same through the persistent tree
+static unsigned long bench_lifecycle_tree(bench_ctx *ctx) {
+  unsigned long gone = ctx->cursor++ % ctx->count, requests;
+
+  gf_layout_tree_remove(&ctx->tree, ctx->leaves[gone]);
+  ctx->plan.count = gf_layout_tree_compute(
+      &ctx->params, &ctx->tree, ctx->area, ctx->plan.windows, ctx->plan.rects);
+  requests = gf_client_table_diff(&ctx->table, &ctx->plan);
+
+  ctx->leaves[gone] = gf_layout_tree_insert(&ctx->tree, ctx->table.id[gone]);
+  ctx->plan.count = gf_layout_tree_compute(
+      &ctx->params, &ctx->tree, ctx->area, ctx->plan.windows, ctx->plan.rects);
+  return requests + gf_client_table_diff(&ctx->table, &ctx->plan);
+}
+
+static unsigned long bench_pipeline(bench_ctx *ctx) {
+  unsigned long requests = 0;
+
+  gf_workspace_snapshot_build(&ctx->snapshot, &ctx->table, ctx->workspaces);
+  for (int workspace = 0; workspace < ctx->workspaces; workspace++) {
+    unsigned long count = 0;
+    Window *windows =
+        gf_workspace_snapshot_windows(&ctx->snapshot, workspace, &count);
+    if (!count)
+      continue;
+
+    memcpy(ctx->plan.windows, windows, count * sizeof(Window));
+    gf_layout_compute(&ctx->params, count, ctx->area, NULL, ctx->plan.rects);
+    ctx->plan.count = count;
+    requests += gf_client_table_diff(&ctx->table, &ctx->plan);
+  }
+  return requests;
+}
+
+static int bench_setup(bench_ctx *ctx, unsigned long count, int workspaces) {
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->count = count;
+  ctx->workspaces = workspaces;
+  ctx->area = (gf_rect){0, 0, 1915, 1080};
+  ctx->params = (gf_layout_params){GF_LAYOUT_BSP, 6, 0.5f};
+
+  if (gf_client_table_init(&ctx->table, count) < 0 ||
+      gf_layout_plan_reserve(&ctx->plan, count) < 0 ||
+      gf_layout_plan_reserve(&ctx->reference, count) < 0 ||
+      !(ctx->leaves = malloc(count * sizeof(*ctx->leaves))))
+    return -1;
+
+  for (unsigned long i = 0; i < count; i++) {
+    long index = gf_client_table_add(&ctx->table, 0x1000000 + i);
+    ctx->table.desktop[index] = (long)(i % workspaces);
+    // Every 16th client carries an excluded state such as a tooltip
+    if (i % 16 == 15)
+      ctx->table.flags[index] |= GF_CLIENT_EXCLUDED;
+    // Every other one is a terminal that only takes whole character cells
+    if (i % 2)
+      ctx->table.hints[index] = (gf_size_hints){.min_width = 40,
+                                                .min_height = 40,
+                                                .base_width = 4,
+                                                .base_height = 4,
+                                                .width_inc = 9,
+                                                .height_inc = 18};
+  }
+
+  for (unsigned long i = 0; i < count; i++) {
+    ctx->reference.windows[i] = ctx->table.id[i];
+    ctx->leaves[i] = gf_layout_tree_insert(&ctx->tree, ctx->table.id[i]);
+  }
+  gf_layout_compute(&ctx->params, count, ctx->area, NULL,
+                    ctx->reference.rects);
+  ctx->reference.count = count;
+
+  // Start from a fully applied layout so commits measure the diff alone
+  bench_reload_plan(ctx);
+  gf_client_table_diff(&ctx->table, &ctx->plan);
+  return 0;
+}
+
+static void bench_teardown(bench_ctx *ctx) {
+  gf_client_table_free(&ctx->table);
+  gf_workspace_snapshot_free(&ctx->snapshot);
+  gf_layout_plan_free(&ctx->plan);
+  gf_layout_plan_free(&ctx->reference);
+  gf_layout_tree_free(&ctx->tree);
+  free(ctx->leaves);
+}
+
+int main(void) {
+  const unsigned long counts[] = {1, 10, 100, 1000};
+  const int workspace_counts[] = {1, 4, 12, 32};
+  const size_t ncounts = sizeof(counts) / sizeof(counts[0]);
+  const size_t nworkspaces =
+      sizeof(workspace_counts) / sizeof(workspace_counts[0]);
+  char name[64];
+  bench_ctx ctx;
+
+  printf("# gridflux_bench 1\n");
+  printf("name\twindows\tworkspaces\titerations\tns_per_op\tallocs_per_op\t"
+         "requests_per_op\n");
+
+  for (size_t i = 0; i < ncounts; i++) {
+    if (bench_setup(&ctx, counts[i], 1) < 0)
+      return EXIT_FAILURE;
+
+    for (int kind = 0; kind < GF_LAYOUT_KIND_COUNT; kind++) {
+      ctx.params.kind = (gf_layout_kind)kind;
+      snprintf(name, sizeof(name), "layout/%s", gf_layout_kind_name(kind));
+      bench_run(name, bench_layout, &ctx);
+      snprintf(name, sizeof(name), "layout/%s+hints",
+               gf_layout_kind_name(kind));
+      bench_run(name, bench_layout_hinted, &ctx);
+    }
+
+    ctx.params.kind = GF_LAYOUT_BSP;
+    bench_run("commit/unchanged", bench_commit_unchanged, &ctx);
+    bench_run("commit/one-changed", bench_commit_one, &ctx);
+    bench_run("lifecycle/flat", bench_lifecycle_flat, &ctx);
+    // The first round moves every window from the flat layout to the tree's
+    bench_lifecycle_tree(&ctx);
+    bench_run("lifecycle/tree", bench_lifecycle_tree, &ctx);
+    bench_teardown(&ctx);
+  }
+
+  for (size_t i = 0; i < ncounts; i++) {
+    for (size_t j = 0; j < nworkspaces; j++) {
+      if (bench_setup(&ctx, counts[i], workspace_counts[j]) < 0)
+        return EXIT_FAILURE;
+
+      bench_run("filter", bench_filter, &ctx);
+      bench_run("bucket", bench_bucket, &ctx);
+      bench_run("pipeline", bench_pipeline, &ctx);
+      bench_teardown(&ctx);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,438 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+// End-to-end tiling benchmark: starts Xvfb, the stand-in window manager and
+// gridflux, maps N windows and reports how long it takes until every one of
+// them has settled on its tiled geometry, how many requests gridflux issued
+// and how much CPU it burns once idle. With --startup the windows exist
+// before gridflux starts, which measures the time to the first tile instead.
+// Exits non-zero past the given limits.
+
+#include <X11/Xlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PERF_SETTLE_MS 300
+#define PERF_TIMEOUT_MS 30000
+#define PERF_IDLE_MS 1000
+
+typedef struct {
+  int windows;
+  const char *gridflux;
+  const char *wm;
+  const char *xvfb;
+  double max_latency_ms;
+  double max_idle_cpu;
+  double max_first_tile_ms;
+  int startup;
+} perf_options;
+
+static pid_t xvfb_pid, wm_pid, gridflux_pid;
+
+static double perf_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void perf_cleanup(void) {
+  pid_t pids[] = {gridflux_pid, wm_pid, xvfb_pid};
+  for (size_t i = 0; i < sizeof(pids) / sizeof(pids[0]); i++) {
+    if (pids[i] > 0) {
+      kill(pids[i], SIGTERM);
+      waitpid(pids[i], NULL, 0);
+    }
+  }
+}
+
+static void perf_fail(const char *message) {
+  fprintf(stderr, "perf_harness: %s\n", message);
+  perf_cleanup();
+  exit(EXIT_FAILURE);
+}
+
+static pid_t perf_spawn(char *const argv[], int stdout_fd, int stderr_fd) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    if (stdout_fd >= 0)
+      dup2(stdout_fd, STDOUT_FILENO);
+    if (stderr_fd >= 0)
+      dup2(stderr_fd, STDERR_FILENO);
+    execvp(argv[0], argv);
+    fprintf(stderr, "perf_harness: cannot exec %s: %s\n", argv[0],
+            strerror(errno));
+    _exit(127);
+  }
+  return pid;
+}
+
+static void perf_start_xvfb(const perf_options *options) {
+  int fds[2];
+  if (pipe(fds) < 0)
+    perf_fail("pipe failed");
+
+  // -displayfd lets the server pick a free display and report it back
+  char displayfd[16];
+  snprintf(displayfd, sizeof(displayfd), "%d", fds[1]);
+  char *argv[] = {(char *)options->xvfb, "-displayfd", displayfd, "-screen",
+                  "0",  "1920x1080x24", "-nolisten", "tcp", NULL};
+  xvfb_pid = perf_spawn(argv, -1, -1);
+  close(fds[1]);
+
+  char number[16] = {0};
+  ssize_t length = 0;
+  struct pollfd pfd = {.fd = fds[0], .events = POLLIN};
+  while (length < (ssize_t)sizeof(number) - 1 && poll(&pfd, 1, 10000) > 0) {
+    ssize_t got = read(fds[0], number + length, sizeof(number) - 1 - length);
+    if (got <= 0 || memchr(number, '\n', length + got))
+      break;
+    length += got;
+  }
+  close(fds[0]);
+
+  int display = atoi(number);
+  if (number[0] < '0' || number[0] > '9')
+    perf_fail("Xvfb did not report a display");
+
+  char name[32];
+  snprintf(name, sizeof(name), ":%d", display);
+  setenv("DISPLAY", name, 1);
+}
+
+static int perf_wait_for(Display *display, int (*ready)(Display *)) {
+  double deadline = perf_now_ms() + 10000;
+  while (perf_now_ms() < deadline) {
+    if (ready(display))
+      return 0;
+    usleep(10000);
+  }
+  return -1;
+}
+
+static int perf_wm_ready(Display *display) {
+  Atom atom = XInternAtom(display, "_NET_NUMBER_OF_DESKTOPS", True);
+  if (atom == None)
+    return 0;
+
+  Atom type;
+  int format;
+  unsigned long nitems, after;
+  unsigned char *data = NULL;
+  XGetWindowProperty(display, DefaultRootWindow(display), atom, 0, 1, False,
+                     AnyPropertyType, &type, &format, &nitems, &after, &data);
+  if (data)
+    XFree(data);
+  return nitems > 0;
+}
+
+static int perf_gridflux_ready(Display *display) {
+  // The stand-in WM never selects PropertyChangeMask on the root window
+  XWindowAttributes attributes;
+  XGetWindowAttributes(display, DefaultRootWindow(display), &attributes);
+  return (attributes.all_event_masks & PropertyChangeMask) != 0;
+}
+
+static int perf_find(const Window *windows, int count, Window window) {
+  int low = 0, high = count - 1;
+  while (low <= high) {
+    int mid = (low + high) / 2;
+    if (windows[mid] == window)
+      return mid;
+    if (windows[mid] < window)
+      low = mid + 1;
+    else
+      high = mid - 1;
+  }
+  return -1;
+}
+
+static Window *perf_create_windows(Display *display, int count) {
+  Window root = DefaultRootWindow(display);
+  Window *windows = calloc(count, sizeof(*windows));
+  if (!windows)
+    perf_fail("out of memory");
+
+  for (int i = 0; i < count; i++) {
+    windows[i] = XCreateSimpleWindow(display, root, 0, 0, 200, 200, 0, 0, 0);
+    XSelectInput(display, windows[i], StructureNotifyMask);
+  }
+  XSync(display, False);
+  return windows;
+}
+
+static void perf_map_windows(Display *display, Window *windows, int count) {
+  for (int i = 0; i < count; i++)
+    XMapWindow(display, windows[i]);
+  XFlush(display);
+}
+
+static int perf_listed_windows;
+
+static int perf_windows_listed(Display *display) {
+  Atom atom = XInternAtom(display, "_NET_CLIENT_LIST", True);
+  if (atom == None)
+    return 0;
+
+  Atom type;
+  int format;
+  unsigned long nitems = 0, after;
+  unsigned char *data = NULL;
+  XGetWindowProperty(display, DefaultRootWindow(display), atom, 0, 1 << 20,
+                     False, AnyPropertyType, &type, &format, &nitems, &after,
+                     &data);
+  if (data)
+    XFree(data);
+  return (int)nitems >= perf_listed_windows;
+}
+
+// Waits until every window got a ConfigureNotify and nothing moved for a
+// while; returns the time of the last one relative to start.
+static double perf_wait_tiled(Display *display, Window *windows, int count,
+                              double start) {
+  char *configured = calloc(count, 1);
+  double last = start;
+  if (!configured)
+    perf_fail("out of memory");
+
+  int settled = 0;
+  struct pollfd pfd = {.fd = ConnectionNumber(display), .events = POLLIN};
+
+  while (perf_now_ms() - start < PERF_TIMEOUT_MS) {
+    while (XPending(display)) {
+      XEvent event;
+      XNextEvent(display, &event);
+      if (event.type != ConfigureNotify)
+        continue;
+
+      // Windows are created in order, so their ids are sorted
+      int index = perf_find(windows, count, event.xconfigure.window);
+      if (index < 0)
+        continue;
+      if (!configured[index]) {
+        configured[index] = 1;
+        settled++;
+      }
+      last = perf_now_ms();
+    }
+
+    if (settled == count && perf_now_ms() - last >= PERF_SETTLE_MS)
+      break;
+    poll(&pfd, 1, PERF_SETTLE_MS / 4);
+  }
+
+  free(configured);
+
+  if (settled != count)
+    perf_fail("timed out waiting for every window to be tiled");
+  return last - start;
+}
+
+static double perf_cpu_seconds(pid_t pid) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+  FILE *file = fopen(path, "r");
+  if (!file)
+    return 0;
+
+  unsigned long utime = 0, stime = 0;
+  // Fields 14 and 15; the command name in field 2 has no spaces here
+  fscanf(file, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+         &utime, &stime);
+  fclose(file);
+  return (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+}
+
+static void perf_read_stats(int fd, unsigned long *requests,
+                            unsigned long *round_trips,
+                            double *first_tile_ms) {
+  FILE *file = fdopen(fd, "r");
+  char *line = NULL;
+  size_t size = 0;
+
+  *requests = *round_trips = 0;
+  *first_tile_ms = 0;
+  while (file && getline(&line, &size, file) > 0) {
+    // Only the last dump counts, earlier ones may come from SIGUSR1
+    if (strncmp(line, "# gridflux stats", 16) == 0)
+      *requests = *round_trips = 0;
+    if (strncmp(line, "startup first_tile_us=", 22) == 0)
+      *first_tile_ms = strtod(line + 22, NULL) / 1000.0;
+    if (strncmp(line, "stage=", 6) != 0)
+      continue;
+
+    for (char *field = strtok(line, " \n"); field;
+         field = strtok(NULL, " \n")) {
+      char *value = strchr(field, '=');
+      if (!value || strncmp(field, "stage=", 6) == 0 ||
+          strncmp(field, "runs=", 5) == 0 ||
+          strncmp(field, "total_us=", 9) == 0 ||
+          strncmp(field, "max_us=", 7) == 0 ||
+          strncmp(field, "hist_us=", 8) == 0 ||
+          // Flushes write buffered requests, they are not requests themselves
+          strncmp(field, "flush=", 6) == 0)
+        continue;
+
+      if (strncmp(field, "round_trips=", 12) == 0)
+        *round_trips += strtoul(value + 1, NULL, 10);
+      else
+        *requests += strtoul(value + 1, NULL, 10);
+    }
+  }
+
+  free(line);
+  if (file)
+    fclose(file);
+}
+
+static void perf_usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s --windows N --gridflux PATH --wm PATH [--xvfb PATH]\n"
+          "          [--startup] [--max-latency-ms MS] [--max-idle-cpu PERCENT]\n"
+          "          [--max-first-tile-ms MS]\n",
+          program);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char **argv) {
+  perf_options options = {.windows = 10,
+                          .xvfb = "Xvfb",
+                          .max_latency_ms = 0,
+                          .max_idle_cpu = 0};
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--startup") == 0) {
+      options.startup = 1;
+      continue;
+    }
+    if (i + 1 >= argc)
+      perf_usage(argv[0]);
+    if (strcmp(argv[i], "--windows") == 0)
+      options.windows = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--gridflux") == 0)
+      options.gridflux = argv[++i];
+    else if (strcmp(argv[i], "--wm") == 0)
+      options.wm = argv[++i];
+    else if (strcmp(argv[i], "--xvfb") == 0)
+      options.xvfb = argv[++i];
+    else if (strcmp(argv[i], "--max-latency-ms") == 0)
+      options.max_latency_ms = atof(argv[++i]);
+    else if (strcmp(argv[i], "--max-idle-cpu") == 0)
+      options.max_idle_cpu = atof(argv[++i]);
+    else if (strcmp(argv[i], "--max-first-tile-ms") == 0)
+      options.max_first_tile_ms = atof(argv[++i]);
+    else
+      perf_usage(argv[0]);
+  }
+  if (!options.gridflux || !options.wm || options.windows <= 0)
+    perf_usage(argv[0]);
+
+  signal(SIGPIPE, SIG_IGN);
+  perf_start_xvfb(&options);
+
+  char *wm_argv[] = {(char *)options.wm, NULL};
+  wm_pid = perf_spawn(wm_argv, -1, -1);
+
+  Display *display = XOpenDisplay(NULL);
+  if (!display)
+    perf_fail("cannot open the Xvfb display");
+  if (perf_wait_for(display, perf_wm_ready) < 0)
+    perf_fail("stand-in window manager did not start");
+
+  Window *windows = perf_create_windows(display, options.windows);
+  if (options.startup) {
+    // Let the stand-in WM list them all so gridflux finds them at startup
+    perf_map_windows(display, windows, options.windows);
+    perf_listed_windows = options.windows;
+    if (perf_wait_for(display, perf_windows_listed) < 0)
+      perf_fail("stand-in window manager did not list the windows");
+    XSync(display, True);
+  }
+
+  int stats[2];
+  int null_fd = open("/dev/null", O_WRONLY);
+  if (pipe(stats) < 0 || null_fd < 0)
+    perf_fail("cannot set up gridflux output");
+
+  setenv("XDG_SESSION_TYPE", "x11", 1);
+  char *gridflux_argv[] = {(char *)options.gridflux, "--stats", NULL};
+  double start = perf_now_ms();
+  gridflux_pid = perf_spawn(gridflux_argv, null_fd, stats[1]);
+  close(stats[1]);
+  close(null_fd);
+
+  double latency;
+  if (options.startup) {
+    latency = perf_wait_tiled(display, windows, options.windows, start);
+  } else {
+    if (perf_wait_for(display, perf_gridflux_ready) < 0)
+      perf_fail("gridflux did not start");
+
+    start = perf_now_ms();
+    perf_map_windows(display, windows, options.windows);
+    latency = perf_wait_tiled(display, windows, options.windows, start);
+  }
+  free(windows);
+
+  double cpu = perf_cpu_seconds(gridflux_pid);
+  usleep(PERF_IDLE_MS * 1000);
+  double idle_cpu =
+      (perf_cpu_seconds(gridflux_pid) - cpu) * 100.0 / (PERF_IDLE_MS / 1000.0);
+
+  unsigned long requests, round_trips;
+  double first_tile;
+  kill(gridflux_pid, SIGTERM);
+  perf_read_stats(stats[0], &requests, &round_trips, &first_tile);
+  waitpid(gridflux_pid, NULL, 0);
+  gridflux_pid = 0;
+
+  XCloseDisplay(display);
+  perf_cleanup();
+
+  printf("windows\tlatency_ms\trequests\tround_trips\tidle_cpu_pct\t"
+         "first_tile_ms\n");
+  printf("%d\t%.2f\t%lu\t%lu\t%.2f\t%.2f\n", options.windows, latency,
+         requests, round_trips, idle_cpu, first_tile);
+
+  int failed = 0;
+  if (options.max_latency_ms > 0 && latency > options.max_latency_ms) {
+    fprintf(stderr, "perf_harness: latency %.2f ms exceeds %.2f ms\n", latency,
+            options.max_latency_ms);
+    failed = 1;
+  }
+  if (options.max_idle_cpu > 0 && idle_cpu > options.max_idle_cpu) {
+    fprintf(stderr, "perf_harness: idle CPU %.2f%% exceeds %.2f%%\n", idle_cpu,
+            options.max_idle_cpu);
+    failed = 1;
+  }
+  if (options.max_first_tile_ms > 0 &&
+      first_tile > options.max_first_tile_ms) {
+    fprintf(stderr, "perf_harness: first tile %.2f ms exceeds %.2f ms\n",
+            first_tile, options.max_first_tile_ms);
+    failed = 1;
+  }
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
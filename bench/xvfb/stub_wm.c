@@ -0,0 +1,196 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+// Minimal stand-in EWMH window manager for the Xvfb performance harness.
+// It never reparents or decorates: it only maps windows, applies configure
+// requests and maintains the root properties gridflux reads.
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define STUB_DESKTOPS 4
+
+static Display *display;
+static Window root;
+static Window *clients;
+static unsigned long client_count;
+static unsigned long client_capacity;
+static long desktop_count = STUB_DESKTOPS;
+static long current_desktop;
+static int other_wm;
+
+static Atom net_supported, net_client_list, net_client_list_stacking,
+    net_number_of_desktops, net_current_desktop, net_wm_desktop,
+    net_wm_state, net_supporting_wm_check;
+
+static int stub_error_handler(Display *dpy, XErrorEvent *error) {
+  (void)dpy;
+  if (error->error_code == BadAccess)
+    other_wm = 1;
+  return 0;
+}
+
+static void stub_set_cardinal(Window window, Atom property, long value) {
+  XChangeProperty(display, window, property, XA_CARDINAL, 32, PropModeReplace,
+                  (unsigned char *)&value, 1);
+}
+
+static void stub_publish_clients(void) {
+  XChangeProperty(display, root, net_client_list, XA_WINDOW, 32,
+                  PropModeReplace, (unsigned char *)clients, client_count);
+  XChangeProperty(display, root, net_client_list_stacking, XA_WINDOW, 32,
+                  PropModeReplace, (unsigned char *)clients, client_count);
+}
+
+static long stub_find(Window window) {
+  for (unsigned long i = 0; i < client_count; i++) {
+    if (clients[i] == window)
+      return (long)i;
+  }
+  return -1;
+}
+
+static void stub_manage(Window window) {
+  if (stub_find(window) >= 0)
+    return;
+
+  if (client_count == client_capacity) {
+    client_capacity = client_capacity ? client_capacity * 2 : 64;
+    clients = realloc(clients, client_capacity * sizeof(*clients));
+    if (!clients) {
+      fprintf(stderr, "stub_wm: out of memory\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  // The desktop has to be set before the window shows up in the list
+  stub_set_cardinal(window, net_wm_desktop, current_desktop);
+  clients[client_count++] = window;
+  stub_publish_clients();
+}
+
+static void stub_unmanage(Window window) {
+  long index = stub_find(window);
+  if (index < 0)
+    return;
+
+  clients[index] = clients[--client_count];
+  stub_publish_clients();
+}
+
+static void stub_handle_message(XClientMessageEvent *event) {
+  if (event->message_type == net_wm_desktop && stub_find(event->window) >= 0) {
+    stub_set_cardinal(event->window, net_wm_desktop, event->data.l[0]);
+  } else if (event->message_type == net_number_of_desktops &&
+             event->data.l[0] > 0) {
+    desktop_count = event->data.l[0];
+    stub_set_cardinal(root, net_number_of_desktops, desktop_count);
+  } else if (event->message_type == net_current_desktop &&
+             event->data.l[0] < desktop_count) {
+    current_desktop = event->data.l[0];
+    stub_set_cardinal(root, net_current_desktop, current_desktop);
+  }
+}
+
+int main(void) {
+  display = XOpenDisplay(NULL);
+  if (!display) {
+    fprintf(stderr, "stub_wm: cannot open display\n");
+    return EXIT_FAILURE;
+  }
+
+  root = DefaultRootWindow(display);
+  XSetErrorHandler(stub_error_handler);
+  XSelectInput(display, root, SubstructureRedirectMask | SubstructureNotifyMask);
+  XSync(display, False);
+  if (other_wm) {
+    fprintf(stderr, "stub_wm: another window manager is running\n");
+    return EXIT_FAILURE;
+  }
+
+  net_supported = XInternAtom(display, "_NET_SUPPORTED", False);
+  net_client_list = XInternAtom(display, "_NET_CLIENT_LIST", False);
+  net_client_list_stacking =
+      XInternAtom(display, "_NET_CLIENT_LIST_STACKING", False);
+  net_number_of_desktops =
+      XInternAtom(display, "_NET_NUMBER_OF_DESKTOPS", False);
+  net_current_desktop = XInternAtom(display, "_NET_CURRENT_DESKTOP", False);
+  net_wm_desktop = XInternAtom(display, "_NET_WM_DESKTOP", False);
+  net_wm_state = XInternAtom(display, "_NET_WM_STATE", False);
+  net_supporting_wm_check =
+      XInternAtom(display, "_NET_SUPPORTING_WM_CHECK", False);
+
+  Atom supported[] = {net_client_list,     net_client_list_stacking,
+                      net_number_of_desktops, net_current_desktop,
+                      net_wm_desktop,      net_wm_state};
+  XChangeProperty(display, root, net_supported, XA_ATOM, 32, PropModeReplace,
+                  (unsigned char *)supported,
+                  sizeof(supported) / sizeof(supported[0]));
+
+  Window check = XCreateSimpleWindow(display, root, 0, 0, 1, 1, 0, 0, 0);
+  XChangeProperty(display, root, net_supporting_wm_check, XA_WINDOW, 32,
+                  PropModeReplace, (unsigned char *)&check, 1);
+  XChangeProperty(display, check, net_supporting_wm_check, XA_WINDOW, 32,
+                  PropModeReplace, (unsigned char *)&check, 1);
+
+  stub_set_cardinal(root, net_current_desktop, current_desktop);
+  stub_publish_clients();
+  // Published last: the harness waits for it before starting gridflux
+  stub_set_cardinal(root, net_number_of_desktops, desktop_count);
+  XSync(display, False);
+
+  XEvent event;
+  while (1) {
+    XNextEvent(display, &event);
+
+    switch (event.type) {
+    case MapRequest:
+      stub_manage(event.xmaprequest.window);
+      XMapWindow(display, event.xmaprequest.window);
+      break;
+    case ConfigureRequest: {
+      XConfigureRequestEvent *request = &event.xconfigurerequest;
+      XWindowChanges changes = {.x = request->x,
+                                .y = request->y,
+                                .width = request->width,
+                                .height = request->height,
+                                .border_width = request->border_width,
+                                .sibling = request->above,
+                                .stack_mode = request->detail};
+      XConfigureWindow(display, request->window, request->value_mask,
+                       &changes);
+      break;
+    }
+    case UnmapNotify:
+      stub_unmanage(event.xunmap.window);
+      break;
+    case DestroyNotify:
+      stub_unmanage(event.xdestroywindow.window);
+      break;
+    case ClientMessage:
+      stub_handle_message(&event.xclient);
+      break;
+    default:
+      break;
+    }
+    XFlush(display);
+  }
+}
@@ -0,0 +1,221 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+// Command line client for the gridflux control socket: one request, one
+// reply, no X connection.
+
+#include "control.h"
+#include "layout.h"
+#include "state.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const char *status_names[] = {
+    [GF_CONTROL_OK] = "ok",
+    [GF_CONTROL_BAD_REQUEST] = "bad request",
+    [GF_CONTROL_UNKNOWN_WINDOW] = "unknown window",
+};
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "Usage: %s [--socket PATH] COMMAND\n"
+          "  relayout [WORKSPACE]        retile a workspace, or all of them\n"
+          "  layout WORKSPACE KIND       bsp, master-stack, columns or grid\n"
+          "  move WINDOW WORKSPACE       send a window to a workspace\n"
+          "  capacity COUNT|unlimited    tiles per workspace\n"
+          "  pause | resume              stop or restart laying out\n"
+          "  query [WORKSPACE]           print the current state\n"
+          "  state                       print the exported layout model\n",
+          program);
+}
+
+static int parse_long(const char *text, long long *value) {
+  char *end;
+  errno = 0;
+  *value = strtoll(text, &end, 0);
+  return errno || end == text || *end ? -1 : 0;
+}
+
+static int parse_request(int argc, char **argv, gf_control_request *request) {
+  const char *command = argv[0];
+  long long first = -1, second = 0;
+
+  request->version = GF_CONTROL_VERSION;
+  request->workspace = -1;
+
+  if (strcmp(command, "relayout") == 0 || strcmp(command, "query") == 0) {
+    if (argc > 2 || (argc == 2 && parse_long(argv[1], &first) < 0))
+      return -1;
+    request->command = command[0] == 'r' ? GF_CONTROL_RELAYOUT
+                                         : GF_CONTROL_QUERY;
+    request->workspace = (int32_t)first;
+  } else if (strcmp(command, "layout") == 0) {
+    if (argc != 3 || parse_long(argv[1], &first) < 0)
+      return -1;
+    gf_layout_kind kind = gf_layout_kind_from_name(argv[2]);
+    if (kind == GF_LAYOUT_KIND_COUNT)
+      return -1;
+    request->command = GF_CONTROL_LAYOUT;
+    request->workspace = (int32_t)first;
+    request->argument = kind;
+  } else if (strcmp(command, "move") == 0) {
+    if (argc != 3 || parse_long(argv[1], &first) < 0 ||
+        parse_long(argv[2], &second) < 0)
+      return -1;
+    request->command = GF_CONTROL_MOVE;
+    request->window = (uint64_t)first;
+    request->workspace = (int32_t)second;
+  } else if (strcmp(command, "capacity") == 0) {
+    if (argc != 2)
+      return -1;
+    if (strcmp(argv[1], "unlimited") == 0)
+      first = 0;
+    else if (parse_long(argv[1], &first) < 0)
+      return -1;
+    request->command = GF_CONTROL_CAPACITY;
+    request->argument = first;
+  } else if (strcmp(command, "pause") == 0 && argc == 1) {
+    request->command = GF_CONTROL_PAUSE;
+  } else if (strcmp(command, "resume") == 0 && argc == 1) {
+    request->command = GF_CONTROL_RESUME;
+  } else {
+    return -1;
+  }
+  return 0;
+}
+
+static void print_state(const gf_control_reply *reply) {
+  printf("paused=%u workspaces=%u windows=%u", reply->paused,
+         reply->workspaces, reply->windows);
+  if (reply->capacity)
+    printf(" capacity=%u", reply->capacity);
+  else
+    printf(" capacity=unlimited");
+  if (reply->workspace >= 0)
+    printf(" workspace=%d layout=%s workspace_windows=%u", reply->workspace,
+           gf_layout_kind_name((gf_layout_kind)reply->layout),
+           reply->workspace_windows);
+  printf("\n");
+}
+
+// Reads the shared-memory export, no request to gridflux at all
+static int print_model(void) {
+  char path[sizeof(((gf_state_export *)0)->path)];
+  gf_state state;
+
+  if (gf_state_path(path, sizeof(path)) < 0) {
+    fprintf(stderr, "Set XDG_RUNTIME_DIR or GRIDFLUX_STATE_FILE (at most %zu "
+                    "characters)\n",
+            sizeof(path) - 1);
+    return 1;
+  }
+
+  const gf_state *mapped = gf_state_map(path);
+  if (!mapped) {
+    fprintf(stderr, "Cannot map %s: %s\n", path, strerror(errno));
+    return 1;
+  }
+  int status = gf_state_read(mapped, &state);
+  gf_state_unmap(mapped);
+  if (status < 0) {
+    fprintf(stderr, "%s is not a state this version understands\n", path);
+    return 1;
+  }
+
+  printf("pid=%d sequence=%llu paused=%u windows=%u", state.pid,
+         (unsigned long long)state.sequence, state.paused, state.windows);
+  if (state.capacity)
+    printf(" capacity=%u", state.capacity);
+  else
+    printf(" capacity=unlimited");
+  printf("%s\n", state.truncated ? " truncated=1" : "");
+
+  for (uint32_t ws = 0; ws < state.workspace_count; ws++) {
+    const gf_state_workspace *workspace = &state.workspaces[ws];
+    printf("workspace=%u layout=%s windows=%u tiles=%u\n", ws,
+           gf_layout_kind_name((gf_layout_kind)workspace->layout),
+           workspace->windows, workspace->tiles);
+    for (uint32_t i = 0; i < workspace->tiles; i++) {
+      const gf_state_tile *tile = &state.tiles[workspace->first_tile + i];
+      printf("  window=0x%llx output=%d x=%d y=%d width=%d height=%d\n",
+             (unsigned long long)tile->window, tile->output, tile->x, tile->y,
+             tile->width, tile->height);
+    }
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+  int first = 1;
+
+  if (argc == 2 && strcmp(argv[1], "state") == 0)
+    return print_model();
+
+  if (argc > 2 && strcmp(argv[1], "--socket") == 0) {
+    snprintf(path, sizeof(path), "%s", argv[2]);
+    first = 3;
+  } else if (gf_control_socket_path(path, sizeof(path)) < 0) {
+    fprintf(stderr, "Set XDG_RUNTIME_DIR or GRIDFLUX_CONTROL_SOCKET (at most "
+                    "%zu characters), or pass --socket\n",
+            sizeof(path) - 1);
+    return 1;
+  }
+
+  gf_control_request request = {0};
+  if (first >= argc || parse_request(argc - first, argv + first, &request) < 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  struct sockaddr_un address = {.sun_family = AF_UNIX};
+  snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (fd < 0 ||
+      connect(fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+    fprintf(stderr, "Cannot connect to %s: %s\n", path, strerror(errno));
+    return 1;
+  }
+
+  gf_control_reply reply;
+  if (send(fd, &request, sizeof(request), MSG_NOSIGNAL) != sizeof(request) ||
+      recv(fd, &reply, sizeof(reply), 0) != sizeof(reply)) {
+    fprintf(stderr, "No reply from gridflux: %s\n", strerror(errno));
+    close(fd);
+    return 1;
+  }
+  close(fd);
+
+  if (reply.status != GF_CONTROL_OK) {
+    fprintf(stderr, "gridflux: %s\n",
+            reply.status <= GF_CONTROL_UNKNOWN_WINDOW
+                ? status_names[reply.status]
+                : "unknown error");
+    return 1;
+  }
+  if (request.command == GF_CONTROL_QUERY)
+    print_state(&reply);
+  return 0;
+}
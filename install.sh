@@ -10,7 +10,7 @@ SERVICE_FILE="/etc/systemd/system/gridflux.service"
 install_dependencies() {
   echo "Detecting distribution and installing dependencies..."
 
-  local dependencies="libx11-dev cmake gcc make"
+  local dependencies="libx11-dev libx11-xcb-dev libxcb1-dev libxrandr-dev cmake gcc make"
 
   if [ -f /etc/os-release ]; then
     . /etc/os-release
@@ -30,12 +30,12 @@ install_dependencies() {
     rhel | fedora | centos | almalinux | rocky)
       echo "Detected RHEL-based distribution."
       sudo dnf check-update || sudo yum check-update
-      sudo dnf install -y libX11-devel cmake gcc make || sudo yum install -y libX11-devel cmake gcc make
+      sudo dnf install -y libX11-devel libxcb-devel libXrandr-devel cmake gcc make || sudo yum install -y libX11-devel libxcb-devel libXrandr-devel cmake gcc make
       ;;
     arch | manjaro)
       echo "Detected Arch-based distribution."
       sudo pacman -Syu --noconfirm
-      sudo pacman -S --noconfirm libx11 cmake gcc make
+      sudo pacman -S --noconfirm libx11 libxcb libxrandr cmake gcc make
       ;;
     *)
       echo "Unsupported distribution: $ID"
@@ -54,8 +54,8 @@ build_and_install() {
   make
 
   echo "Installing gridflux to $INSTALL_DIR..."
-  sudo cp gridflux "$INSTALL_DIR/"
-  sudo chmod +x "$INSTALL_DIR/gridflux"
+  sudo cp gridflux gridfluxctl "$INSTALL_DIR/"
+  sudo chmod +x "$INSTALL_DIR/gridflux" "$INSTALL_DIR/gridfluxctl"
 }
 
 create_systemd_service() {
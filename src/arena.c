@@ -0,0 +1,74 @@
+#include "arena.h"
+#include "ewmh.h"
+#include "gridflux.h"
+#include <stdlib.h>
+
+#define GF_ARENA_ALIGN 16
+#define GF_ARENA_MIN_CHUNK 4096
+
+static size_t gf_arena_round(size_t size) {
+  return (size + GF_ARENA_ALIGN - 1) & ~(size_t)(GF_ARENA_ALIGN - 1);
+}
+
+static gf_arena_chunk *gf_arena_chunk_new(size_t size, gf_arena_chunk *next) {
+  gf_arena_chunk *chunk = malloc(sizeof(*chunk) + size);
+  if (!chunk) {
+    LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+    return NULL;
+  }
+
+  chunk->next = next;
+  chunk->size = size;
+  chunk->used = 0;
+  return chunk;
+}
+
+void *gf_arena_alloc(gf_arena *arena, size_t size) {
+  size = gf_arena_round(size ? size : 1);
+
+  gf_arena_chunk *chunk = arena->chunks;
+  if (!chunk || chunk->size - chunk->used < size) {
+    size_t chunk_size = chunk ? chunk->size * 2 : GF_ARENA_MIN_CHUNK;
+    while (chunk_size < size)
+      chunk_size *= 2;
+
+    chunk = gf_arena_chunk_new(chunk_size, arena->chunks);
+    if (!chunk)
+      return NULL;
+    arena->chunks = chunk;
+  }
+
+  void *memory = chunk->data + chunk->used;
+  chunk->used += size;
+  arena->cycle_used += size;
+  return memory;
+}
+
+void gf_arena_reset(gf_arena *arena) {
+  gf_arena_chunk *chunk = arena->chunks;
+  if (chunk && chunk->next) {
+    // The last cycle spilled over; fold into one chunk big enough for it
+    size_t size = chunk->size;
+    while (size < arena->cycle_used)
+      size *= 2;
+
+    gf_arena_free(arena);
+    arena->chunks = gf_arena_chunk_new(size, NULL);
+  } else if (chunk) {
+    chunk->used = 0;
+  }
+
+  arena->cycle_used = 0;
+}
+
+void gf_arena_free(gf_arena *arena) {
+  gf_arena_chunk *chunk = arena->chunks;
+  while (chunk) {
+    gf_arena_chunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+
+  arena->chunks = NULL;
+  arena->cycle_used = 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_ARENA
+#define GF_ARENA
+
+#include <stddef.h>
+
+typedef struct gf_arena_chunk {
+  struct gf_arena_chunk *next;
+  size_t size;
+  size_t used;
+  unsigned char data[];
+} gf_arena_chunk;
+
+// Bump allocator for memory that lives for one processing cycle: window
+// lists, request cookies and layout scratch. Nothing is freed on its own;
+// gf_arena_reset releases everything at once at the start of the next
+// cycle, and once the arena has grown to the busiest cycle it no longer
+// touches the heap.
+typedef struct {
+  gf_arena_chunk *chunks;
+  size_t cycle_used;
+} gf_arena;
+
+void *gf_arena_alloc(gf_arena *arena, size_t size);
+void gf_arena_reset(gf_arena *arena);
+void gf_arena_free(gf_arena *arena);
+
+#endif // GF_ARENA
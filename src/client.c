@@ -0,0 +1,376 @@
+#include "client.h"
+#include "ewmh.h"
+#include "gridflux.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int gf_column_grow(void **column, size_t size,
+                          unsigned long capacity) {
+  void *grown = realloc(*column, capacity * size);
+  if (!grown)
+    return -1;
+
+  *column = grown;
+  return 0;
+}
+
+static void gf_column_erase(void *column, size_t size, unsigned long index,
+                            unsigned long count) {
+  char *base = column;
+  memmove(base + index * size, base + (index + 1) * size,
+          (count - index - 1) * size);
+}
+
+static unsigned long gf_client_slot(const gf_client_table *table,
+                                    Window window) {
+  // Fibonacci hashing spreads the sequential ids X hands out
+  return (unsigned long)(((unsigned long long)window * 11400714819323198485ULL) >>
+                         32) &
+         (table->slot_count - 1);
+}
+
+static void gf_client_index_insert(gf_client_table *table, unsigned long row) {
+  unsigned long slot = gf_client_slot(table, table->id[row]);
+  while (table->slots[slot] >= 0)
+    slot = (slot + 1) & (table->slot_count - 1);
+  table->slots[slot] = (long)row;
+}
+
+static void gf_client_index_rebuild(gf_client_table *table) {
+  for (unsigned long i = 0; i < table->slot_count; i++)
+    table->slots[i] = -1;
+  for (unsigned long row = 0; row < table->count; row++)
+    gf_client_index_insert(table, row);
+}
+
+static int gf_client_table_grow(gf_client_table *table,
+                                unsigned long capacity) {
+  if (gf_column_grow((void **)&table->id, sizeof(*table->id), capacity) < 0 ||
+      gf_column_grow((void **)&table->desktop, sizeof(*table->desktop),
+                     capacity) < 0 ||
+      gf_column_grow((void **)&table->flags, sizeof(*table->flags), capacity) <
+          0 ||
+      gf_column_grow((void **)&table->geometry, sizeof(*table->geometry),
+                     capacity) < 0 ||
+      gf_column_grow((void **)&table->applied, sizeof(*table->applied),
+                     capacity) < 0 ||
+      gf_column_grow((void **)&table->output, sizeof(*table->output),
+                     capacity) < 0 ||
+      gf_column_grow((void **)&table->leaf, sizeof(*table->leaf), capacity) <
+          0 ||
+      gf_column_grow((void **)&table->hints, sizeof(*table->hints),
+                     capacity) < 0 ||
+      gf_column_grow((void **)&table->frame, sizeof(*table->frame),
+                     capacity) < 0 ||
+      gf_column_grow((void **)&table->sync, sizeof(*table->sync), capacity) <
+          0) {
+    LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+    return -1;
+  }
+
+  unsigned long slot_count = 16;
+  while (slot_count < capacity * 2)
+    slot_count *= 2;
+
+  if (slot_count != table->slot_count) {
+    if (gf_column_grow((void **)&table->slots, sizeof(*table->slots),
+                       slot_count) < 0) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return -1;
+    }
+    table->slot_count = slot_count;
+    gf_client_index_rebuild(table);
+  }
+
+  table->capacity = capacity;
+  return 0;
+}
+
+int gf_client_table_init(gf_client_table *table, unsigned long capacity) {
+  memset(table, 0, sizeof(*table));
+  return gf_client_table_grow(table, capacity ? capacity : 16);
+}
+
+void gf_client_table_free(gf_client_table *table) {
+  free(table->id);
+  free(table->desktop);
+  free(table->flags);
+  free(table->geometry);
+  free(table->applied);
+  free(table->output);
+  free(table->leaf);
+  free(table->hints);
+  free(table->frame);
+  free(table->sync);
+  free(table->slots);
+  memset(table, 0, sizeof(*table));
+}
+
+void gf_client_table_invalidate(gf_client_table *table, unsigned long index) {
+  // No layout produces a negative size, so the next commit always differs
+  table->applied[index] = (gf_rect){0, 0, -1, -1};
+}
+
+void gf_client_table_set_desktop(gf_client_table *table, unsigned long index,
+                                 long desktop) {
+  // The real WM may have placed it anywhere while it was elsewhere
+  if (table->desktop[index] != desktop)
+    gf_client_table_invalidate(table, index);
+  table->desktop[index] = desktop;
+}
+
+void gf_client_table_set_frame(gf_client_table *table, unsigned long index,
+                               gf_frame_extents frame) {
+  gf_frame_extents *current = &table->frame[index];
+
+  // Same tile, different client rect: the next commit has to resend it
+  if (current->left != frame.left || current->right != frame.right ||
+      current->top != frame.top || current->bottom != frame.bottom)
+    gf_client_table_invalidate(table, index);
+  *current = frame;
+}
+
+gf_rect gf_client_table_client_rect(const gf_client_table *table,
+                                    unsigned long index, gf_rect outer) {
+  const gf_frame_extents *frame = &table->frame[index];
+
+  outer.x += frame->left;
+  outer.y += frame->top;
+  outer.width -= frame->left + frame->right;
+  outer.height -= frame->top + frame->bottom;
+  if (outer.width < 1)
+    outer.width = 1;
+  if (outer.height < 1)
+    outer.height = 1;
+  return outer;
+}
+
+gf_size_hints gf_client_table_outer_hints(const gf_client_table *table,
+                                          unsigned long index) {
+  gf_size_hints hints = table->hints[index];
+  const gf_frame_extents *frame = &table->frame[index];
+  int horizontal = frame->left + frame->right;
+  int vertical = frame->top + frame->bottom;
+
+  // The solver sizes tiles, so every bound moves out by the decorations
+  if (hints.min_width)
+    hints.min_width += horizontal;
+  if (hints.min_height)
+    hints.min_height += vertical;
+  if (hints.max_width)
+    hints.max_width += horizontal;
+  if (hints.max_height)
+    hints.max_height += vertical;
+  hints.base_width += horizontal;
+  hints.base_height += vertical;
+  return hints;
+}
+
+long gf_client_table_find(const gf_client_table *table, Window window) {
+  if (table->slot_count == 0)
+    return -1;
+
+  unsigned long slot = gf_client_slot(table, window);
+  while (table->slots[slot] >= 0) {
+    if (table->id[table->slots[slot]] == window)
+      return table->slots[slot];
+    slot = (slot + 1) & (table->slot_count - 1);
+  }
+  return -1;
+}
+
+long gf_client_table_add(gf_client_table *table, Window window) {
+  long index = gf_client_table_find(table, window);
+  if (index >= 0)
+    return index;
+
+  if (table->count == table->capacity &&
+      gf_client_table_grow(table, table->capacity * 2) < 0)
+    return -1;
+
+  index = (long)table->count++;
+  table->id[index] = window;
+  table->desktop[index] = GF_DESKTOP_UNKNOWN;
+  table->flags[index] = 0;
+  table->geometry[index] = (gf_rect){0, 0, 0, 0};
+  table->output[index] = -1;
+  memset(&table->leaf[index], 0, sizeof(table->leaf[index]));
+  memset(&table->hints[index], 0, sizeof(table->hints[index]));
+  memset(&table->frame[index], 0, sizeof(table->frame[index]));
+  memset(&table->sync[index], 0, sizeof(table->sync[index]));
+  gf_client_table_invalidate(table, index);
+  gf_client_index_insert(table, index);
+  return index;
+}
+
+void gf_client_table_remove(gf_client_table *table, unsigned long index) {
+  if (index >= table->count)
+    return;
+
+  // Keep _NET_CLIENT_LIST order so tiles do not reshuffle on close
+  gf_column_erase(table->id, sizeof(*table->id), index, table->count);
+  gf_column_erase(table->desktop, sizeof(*table->desktop), index,
+                  table->count);
+  gf_column_erase(table->flags, sizeof(*table->flags), index, table->count);
+  gf_column_erase(table->geometry, sizeof(*table->geometry), index,
+                  table->count);
+  gf_column_erase(table->applied, sizeof(*table->applied), index,
+                  table->count);
+  gf_column_erase(table->output, sizeof(*table->output), index, table->count);
+  gf_column_erase(table->leaf, sizeof(*table->leaf), index, table->count);
+  gf_column_erase(table->hints, sizeof(*table->hints), index, table->count);
+  gf_column_erase(table->frame, sizeof(*table->frame), index, table->count);
+  gf_column_erase(table->sync, sizeof(*table->sync), index, table->count);
+  table->count--;
+
+  // Every later row shifted down; erasing already cost a pass over them
+  gf_client_index_rebuild(table);
+}
+
+unsigned long gf_client_table_sync(gf_client_table *table,
+                                   const Window *windows, unsigned long count,
+                                   gf_client_removed removed,
+                                   void *user_data) {
+  for (unsigned long i = 0; i < count; i++) {
+    long index = gf_client_table_find(table, windows[i]);
+    if (index >= 0)
+      table->flags[index] |= GF_CLIENT_LISTED;
+  }
+
+  for (unsigned long i = table->count; i-- > 0;) {
+    if (table->flags[i] & GF_CLIENT_LISTED) {
+      table->flags[i] &= ~GF_CLIENT_LISTED;
+      continue;
+    }
+
+    if (removed)
+      removed(user_data, table, i);
+    gf_client_table_remove(table, i);
+  }
+
+  unsigned long first = table->count;
+  for (unsigned long i = 0; i < count; i++)
+    gf_client_table_add(table, windows[i]);
+
+  return first;
+}
+
+unsigned long gf_client_table_diff(gf_client_table *table,
+                                   gf_layout_plan *plan) {
+  unsigned long changed = 0;
+
+  // Compact the plan down to the entries that still need a configure and
+  // record them as applied; unknown windows are always kept
+  for (unsigned long i = 0; i < plan->count; i++) {
+    long index = gf_client_table_find(table, plan->windows[i]);
+    if (index >= 0 && gf_rect_equal(table->applied[index], plan->rects[i]))
+      continue;
+
+    if (index >= 0)
+      table->applied[index] = plan->rects[i];
+
+    plan->windows[changed] = plan->windows[i];
+    plan->rects[changed] = plan->rects[i];
+    changed++;
+  }
+
+  plan->count = changed;
+  return changed;
+}
+
+unsigned long gf_client_table_filter(const gf_client_table *table, long desktop,
+                                     Window *out) {
+  unsigned long count = 0;
+  for (unsigned long i = 0; i < table->count; i++) {
+    if (table->desktop[i] != desktop || (table->flags[i] & GF_CLIENT_EXCLUDED))
+      continue;
+
+    if (out)
+      out[count] = table->id[i];
+    count++;
+  }
+  return count;
+}
+
+int gf_workspace_snapshot_build(gf_workspace_snapshot *snapshot,
+                                const gf_client_table *table,
+                                int workspace_count) {
+  if (workspace_count < 0)
+    workspace_count = 0;
+
+  if (table->count > snapshot->window_capacity) {
+    Window *windows =
+        realloc(snapshot->windows, table->count * sizeof(*windows));
+    if (!windows) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return -1;
+    }
+    snapshot->windows = windows;
+    snapshot->window_capacity = table->count;
+  }
+
+  if (workspace_count > snapshot->workspace_capacity) {
+    unsigned long *offset =
+        realloc(snapshot->offset, workspace_count * sizeof(*offset));
+    if (offset)
+      snapshot->offset = offset;
+    unsigned long *count =
+        realloc(snapshot->count, workspace_count * sizeof(*count));
+    if (count)
+      snapshot->count = count;
+    if (!offset || !count) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return -1;
+    }
+    snapshot->workspace_capacity = workspace_count;
+  }
+
+  snapshot->workspace_count = workspace_count;
+  snapshot->total = 0;
+  if (workspace_count == 0)
+    return 0;
+
+  memset(snapshot->count, 0, workspace_count * sizeof(*snapshot->count));
+  for (unsigned long i = 0; i < table->count; i++) {
+    long desktop = table->desktop[i];
+    if (desktop < 0 || desktop >= workspace_count ||
+        (table->flags[i] & GF_CLIENT_EXCLUDED))
+      continue;
+    snapshot->count[desktop]++;
+  }
+
+  for (int i = 0; i < workspace_count; i++) {
+    snapshot->offset[i] = snapshot->total;
+    snapshot->total += snapshot->count[i];
+    snapshot->count[i] = 0;
+  }
+
+  for (unsigned long i = 0; i < table->count; i++) {
+    long desktop = table->desktop[i];
+    if (desktop < 0 || desktop >= workspace_count ||
+        (table->flags[i] & GF_CLIENT_EXCLUDED))
+      continue;
+    snapshot->windows[snapshot->offset[desktop] + snapshot->count[desktop]++] =
+        table->id[i];
+  }
+
+  return 0;
+}
+
+void gf_workspace_snapshot_free(gf_workspace_snapshot *snapshot) {
+  free(snapshot->windows);
+  free(snapshot->offset);
+  free(snapshot->count);
+  memset(snapshot, 0, sizeof(*snapshot));
+}
+
+Window *gf_workspace_snapshot_windows(const gf_workspace_snapshot *snapshot,
+                                      int workspace, unsigned long *count) {
+  if (workspace < 0 || workspace >= snapshot->workspace_count) {
+    *count = 0;
+    return NULL;
+  }
+
+  *count = snapshot->count[workspace];
+  return *count ? &snapshot->windows[snapshot->offset[workspace]] : NULL;
+}
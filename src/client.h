@@ -0,0 +1,142 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_CLIENT
+#define GF_CLIENT
+
+#include "layout.h"
+#include <X11/X.h>
+
+#define GF_CLIENT_EXCLUDED (1 << 0)
+#define GF_CLIENT_LISTED (1 << 1) // scratch mark while syncing the client list
+#define GF_CLIENT_CONFIGURING (1 << 2) // a configure of ours awaits its notify
+#define GF_CLIENT_TILED (1 << 3) // scratch mark while syncing a layout tree
+#define GF_CLIENT_SYNC (1 << 4)  // speaks _NET_WM_SYNC_REQUEST
+#define GF_CLIENT_SYNCING (1 << 5) // has not painted our last configure yet
+#define GF_CLIENT_HELD (1 << 6)    // `applied` waits for that to be sent
+
+// What a property fetch reports; the other flags are the pipeline's own
+#define GF_CLIENT_FETCHED (GF_CLIENT_EXCLUDED | GF_CLIENT_SYNC)
+
+#define GF_DESKTOP_UNKNOWN (-1L)
+
+// Decorations around the client window: _NET_FRAME_EXTENTS less the
+// client-side shadows of _GTK_FRAME_EXTENTS, so a side can be negative.
+typedef struct {
+  int left;
+  int right;
+  int top;
+  int bottom;
+} gf_frame_extents;
+
+// _NET_WM_SYNC_REQUEST bookkeeping: the client's XSync counter, the alarm
+// watching it and when we stop waiting for the client to catch up.
+typedef struct {
+  XID counter;
+  XID alarm;
+  unsigned long long deadline_ns;
+} gf_client_sync;
+
+// Where a window sits in the planner's BSP trees: `tree` numbers the tree
+// from 1, so a zeroed entry means the window has no leaf anywhere.
+typedef struct {
+  int tree;
+  int node;
+} gf_client_leaf;
+
+// Resident view of the managed clients, one array per field so workspace
+// scans only touch the id/desktop/flags columns. `geometry` is the last
+// root-relative geometry reported by the server, `applied` the last layout
+// rect we committed, `output` the monitor it was last tiled on and `leaf`
+// its tile in that monitor's tree, `hints` its cached WM_NORMAL_HINTS and
+// `frame` its cached frame extents, both refreshed only when the property
+// changes, and `sync` paces configures to its repaints. Layout rects,
+// `applied` included, cover the frame; only the configure sent to the
+// server is the client rect.
+typedef struct {
+  Window *id;
+  long *desktop;
+  unsigned int *flags;
+  gf_rect *geometry;
+  gf_rect *applied;
+  int *output;
+  gf_client_leaf *leaf;
+  gf_size_hints *hints;
+  gf_frame_extents *frame;
+  gf_client_sync *sync;
+
+  unsigned long count;
+  unsigned long capacity;
+
+  // Open-addressing index from window id to row, at most half full
+  long *slots;
+  unsigned long slot_count;
+} gf_client_table;
+
+// Managed clients bucketed by workspace from one scan of the client table,
+// kept in client-list order within each workspace.
+typedef struct {
+  Window *windows;
+  unsigned long *offset;
+  unsigned long *count;
+  int workspace_count;
+  unsigned long total;
+
+  unsigned long window_capacity;
+  int workspace_capacity;
+} gf_workspace_snapshot;
+
+// Called for a row about to leave the table, while it can still be read
+typedef void (*gf_client_removed)(void *user_data, gf_client_table *table,
+                                  unsigned long index);
+
+int gf_client_table_init(gf_client_table *table, unsigned long capacity);
+void gf_client_table_free(gf_client_table *table);
+
+void gf_client_table_invalidate(gf_client_table *table, unsigned long index);
+void gf_client_table_set_desktop(gf_client_table *table, unsigned long index,
+                                 long desktop);
+void gf_client_table_set_frame(gf_client_table *table, unsigned long index,
+                               gf_frame_extents frame);
+gf_rect gf_client_table_client_rect(const gf_client_table *table,
+                                    unsigned long index, gf_rect outer);
+gf_size_hints gf_client_table_outer_hints(const gf_client_table *table,
+                                          unsigned long index);
+long gf_client_table_find(const gf_client_table *table, Window window);
+long gf_client_table_add(gf_client_table *table, Window window);
+void gf_client_table_remove(gf_client_table *table, unsigned long index);
+// Drops rows missing from `windows` and appends the new ones, keeping the
+// list's order; returns the index of the first new row.
+unsigned long gf_client_table_sync(gf_client_table *table,
+                                   const Window *windows, unsigned long count,
+                                   gf_client_removed removed, void *user_data);
+
+unsigned long gf_client_table_diff(gf_client_table *table,
+                                   gf_layout_plan *plan);
+unsigned long gf_client_table_filter(const gf_client_table *table, long desktop,
+                                     Window *out);
+
+int gf_workspace_snapshot_build(gf_workspace_snapshot *snapshot,
+                                const gf_client_table *table,
+                                int workspace_count);
+void gf_workspace_snapshot_free(gf_workspace_snapshot *snapshot);
+Window *gf_workspace_snapshot_windows(const gf_workspace_snapshot *snapshot,
+                                      int workspace, unsigned long *count);
+
+#endif // GF_CLIENT
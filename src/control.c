@@ -0,0 +1,225 @@
+#include "control.h"
+#include "gridflux.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define GF_CONTROL_SLOT_BITS 4 // enough for GF_CONTROL_MAX_CLIENTS
+
+int gf_control_socket_path(char *path, size_t size) {
+  const char *configured = getenv("GRIDFLUX_CONTROL_SOCKET");
+  const char *runtime = getenv("XDG_RUNTIME_DIR");
+  int length;
+
+  if (configured && *configured)
+    length = snprintf(path, size, "%s", configured);
+  else if (runtime && *runtime)
+    length = snprintf(path, size, "%s/" GF_CONTROL_SOCKET_NAME, runtime);
+  else
+    return -1;
+  return length < 0 || (size_t)length >= size ? -1 : 0;
+}
+
+static int gf_control_address(const char *path, struct sockaddr_un *address) {
+  memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address->sun_path))
+    return -1;
+  strcpy(address->sun_path, path);
+  return 0;
+}
+
+int gf_control_open(gf_control_server *server, const char *path) {
+  struct sockaddr_un address;
+
+  server->listen_fd = -1;
+  for (int i = 0; i < GF_CONTROL_MAX_CLIENTS; i++) {
+    server->clients[i] = -1;
+    server->generation[i] = 0;
+    server->deferred[i] = 0;
+  }
+  if (gf_control_address(path, &address) < 0 ||
+      strlen(path) >= sizeof(server->path)) {
+    LOG(GF_WARN, "Control socket path too long: %s", path);
+    return -1;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    LOG(GF_WARN, "Cannot create control socket: %s", strerror(errno));
+    return -1;
+  }
+
+  // A socket someone still answers on belongs to another instance
+  if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0) {
+    LOG(GF_WARN, "Another gridflux owns %s, control disabled", path);
+    close(fd);
+    return -1;
+  }
+  close(fd);
+
+  // Only a stale socket is ours to clear; anything else stays untouched
+  struct stat status;
+  if (lstat(path, &status) == 0) {
+    if (!S_ISSOCK(status.st_mode)) {
+      LOG(GF_WARN, "%s exists and is not a socket, control disabled", path);
+      return -1;
+    }
+    unlink(path);
+  }
+
+  fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+      chmod(path, S_IRUSR | S_IWUSR) < 0 || listen(fd, 4) < 0) {
+    LOG(GF_WARN, "Cannot listen on %s: %s", path, strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    return -1;
+  }
+
+  server->listen_fd = fd;
+  strcpy(server->path, path);
+  LOG(GF_INFO, "Listening for commands on %s", path);
+  return 0;
+}
+
+static void gf_control_drop(gf_control_server *server, int slot) {
+  close(server->clients[slot]);
+  server->clients[slot] = -1;
+  server->generation[slot]++;
+  server->deferred[slot] = 0;
+}
+
+void gf_control_close(gf_control_server *server) {
+  if (server->listen_fd < 0)
+    return;
+
+  for (int i = 0; i < GF_CONTROL_MAX_CLIENTS; i++) {
+    if (server->clients[i] >= 0)
+      gf_control_drop(server, i);
+  }
+  close(server->listen_fd);
+  unlink(server->path);
+  server->listen_fd = -1;
+}
+
+int gf_control_poll_fds(const gf_control_server *server, struct pollfd *fds) {
+  int count = 0;
+  if (server->listen_fd < 0)
+    return 0;
+
+  fds[count++] = (struct pollfd){.fd = server->listen_fd, .events = POLLIN};
+  for (int i = 0; i < GF_CONTROL_MAX_CLIENTS; i++) {
+    if (server->clients[i] >= 0)
+      fds[count++] = (struct pollfd){
+          .fd = server->clients[i],
+          .events = server->deferred[i] ? 0 : POLLIN};
+  }
+  return count;
+}
+
+static void gf_control_accept(gf_control_server *server) {
+  int fd;
+  while ((fd = accept(server->listen_fd, NULL, NULL)) >= 0) {
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    int slot = 0;
+    while (slot < GF_CONTROL_MAX_CLIENTS && server->clients[slot] >= 0)
+      slot++;
+
+    if (slot == GF_CONTROL_MAX_CLIENTS) {
+      LOG(GF_WARN, "Too many control clients, refusing one");
+      close(fd);
+      continue;
+    }
+    server->clients[slot] = fd;
+  }
+}
+
+static unsigned long gf_control_requester(const gf_control_server *server,
+                                          int slot) {
+  return (server->generation[slot] << GF_CONTROL_SLOT_BITS) |
+         (unsigned long)slot;
+}
+
+static void gf_control_read(gf_control_server *server, int slot,
+                            gf_control_handler handler, void *user_data) {
+  gf_control_request request;
+
+  for (;;) {
+    ssize_t length = recv(server->clients[slot], &request, sizeof(request), 0);
+    if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return;
+    if (length <= 0) {
+      gf_control_drop(server, slot);
+      return;
+    }
+
+    unsigned long requester = gf_control_requester(server, slot);
+    if ((size_t)length != sizeof(request) ||
+        request.version != GF_CONTROL_VERSION) {
+      gf_control_reply_to(server, requester,
+                          &(gf_control_reply){.status = GF_CONTROL_BAD_REQUEST});
+      continue;
+    }
+    // Later requests wait in the socket so the replies keep their order
+    if (handler(user_data, requester, &request)) {
+      server->deferred[slot] = 1;
+      return;
+    }
+
+    // The handler may have answered with an error that closed it
+    if (server->clients[slot] < 0)
+      return;
+  }
+}
+
+void gf_control_dispatch(gf_control_server *server, const struct pollfd *fds,
+                         int count, gf_control_handler handler,
+                         void *user_data) {
+  for (int i = 0; i < count; i++) {
+    if (!fds[i].revents)
+      continue;
+
+    if (fds[i].fd == server->listen_fd) {
+      gf_control_accept(server);
+      continue;
+    }
+
+    for (int slot = 0; slot < GF_CONTROL_MAX_CLIENTS; slot++) {
+      if (server->clients[slot] != fds[i].fd)
+        continue;
+
+      if (fds[i].revents & POLLIN)
+        gf_control_read(server, slot, handler, user_data);
+      else
+        gf_control_drop(server, slot);
+      break;
+    }
+  }
+}
+
+void gf_control_reply_to(gf_control_server *server, unsigned long requester,
+                         const gf_control_reply *reply) {
+  int slot = (int)(requester & ((1UL << GF_CONTROL_SLOT_BITS) - 1));
+  if (slot >= GF_CONTROL_MAX_CLIENTS || server->clients[slot] < 0 ||
+      server->generation[slot] != requester >> GF_CONTROL_SLOT_BITS)
+    return;
+
+  server->deferred[slot] = 0;
+  gf_control_reply message = *reply;
+  message.version = GF_CONTROL_VERSION;
+
+  // A client that stopped reading loses its replies, not our event loop
+  if (send(server->clients[slot], &message, sizeof(message),
+           MSG_DONTWAIT | MSG_NOSIGNAL) < 0 &&
+      errno != EAGAIN && errno != EWOULDBLOCK)
+    gf_control_drop(server, slot);
+}
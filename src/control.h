@@ -0,0 +1,105 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_CONTROL
+#define GF_CONTROL
+
+#include <poll.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define GF_CONTROL_VERSION 1
+#define GF_CONTROL_SOCKET_NAME "gridflux.sock"
+#define GF_CONTROL_MAX_CLIENTS 8
+
+typedef enum {
+  GF_CONTROL_RELAYOUT = 1, // workspace, -1 for all: retile from scratch
+  GF_CONTROL_LAYOUT,       // workspace, argument: gf_layout_kind
+  GF_CONTROL_MOVE,         // window, workspace
+  GF_CONTROL_CAPACITY,     // argument: tiles per workspace, 0 for no limit
+  GF_CONTROL_PAUSE,        // stop laying out, inputs are still tracked
+  GF_CONTROL_RESUME,
+  GF_CONTROL_QUERY,        // workspace to report on, -1 for none
+} gf_control_command;
+
+typedef enum {
+  GF_CONTROL_OK,
+  GF_CONTROL_BAD_REQUEST,
+  GF_CONTROL_UNKNOWN_WINDOW,
+} gf_control_status;
+
+// One request per datagram of a SOCK_SEQPACKET connection, in host byte
+// order since the socket never leaves the machine. Every request gets
+// exactly one reply, in order; only a query fills in more than `status`.
+// A connection is not read again until its last request has been answered.
+typedef struct {
+  uint8_t version;
+  uint8_t command;
+  uint16_t reserved;
+  int32_t workspace;
+  int64_t argument;
+  uint64_t window;
+} gf_control_request;
+
+typedef struct {
+  uint8_t version;
+  uint8_t status;
+  uint8_t paused;
+  uint8_t layout; // gf_layout_kind of the queried workspace
+  int32_t workspace;
+  uint32_t capacity; // 0 for no limit
+  uint32_t workspaces;
+  uint32_t windows;           // managed in total
+  uint32_t workspace_windows; // on the queried workspace
+} gf_control_reply;
+
+// Listening end, polled by the event loop. A client is told apart from an
+// earlier one in the same slot by its generation, so a late reply never
+// reaches the wrong peer.
+typedef struct {
+  int listen_fd;
+  int clients[GF_CONTROL_MAX_CLIENTS];
+  unsigned long generation[GF_CONTROL_MAX_CLIENTS];
+  int deferred[GF_CONTROL_MAX_CLIENTS]; // awaiting a gf_control_reply_to
+  char path[108];
+} gf_control_server;
+
+// Returns nonzero when the reply comes later through gf_control_reply_to.
+typedef int (*gf_control_handler)(void *user_data, unsigned long requester,
+                                  const gf_control_request *request);
+
+// GRIDFLUX_CONTROL_SOCKET, else gridflux.sock in $XDG_RUNTIME_DIR. Returns
+// -1 when neither is set or the path does not fit.
+int gf_control_socket_path(char *path, size_t size);
+
+int gf_control_open(gf_control_server *server, const char *path);
+void gf_control_close(gf_control_server *server);
+// Adds the listening socket and every connection to `fds`, returns how many;
+// one awaiting a deferred reply only reports a hangup.
+int gf_control_poll_fds(const gf_control_server *server, struct pollfd *fds);
+// Accepts and reads whatever `fds` reported ready, calling `handler` for
+// each well-formed request; others are answered with BAD_REQUEST.
+void gf_control_dispatch(gf_control_server *server, const struct pollfd *fds,
+                         int count, gf_control_handler handler,
+                         void *user_data);
+// Drops the reply when the requester has gone away meanwhile.
+void gf_control_reply_to(gf_control_server *server, unsigned long requester,
+                         const gf_control_reply *reply);
+
+#endif // GF_CONTROL
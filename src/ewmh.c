@@ -1,99 +1,137 @@
 #include "ewmh.h"
 #include "gridflux.h"
-#include "xwm.h"
+#include "stats.h"
+#include <X11/Xlib-xcb.h>
+#include <stdlib.h>
 #include <string.h>
 
 gf_atom_type atoms;
 
-void gf_init_atom(Display *display) {
-  atoms.wm_state = XInternAtom(display, "WM_STATE", False);
-  atoms.net_wm_state = XInternAtom(display, "_NET_WM_STATE", False);
-  atoms.net_wm_max_horz =
-      XInternAtom(display, "_NET_WM_STATE_MAXIMIZED_HORZ", False);
-  atoms.net_wm_max_vert =
-      XInternAtom(display, "_NET_WM_STATE_MAXIMIZED_VERT", False);
-  atoms.net_wm_desktop = XInternAtom(display, "_NET_WM_DESKTOP", True);
-  atoms.net_wm_type = XInternAtom(display, "_NET_WM_WINDOW_TYPE", False);
-  atoms.net_wm_tooltip =
-      XInternAtom(display, "_NET_WM_WINDOW_TYPE_TOOLTIP", True);
-  atoms.net_wm_notification =
-      XInternAtom(display, "_NET_WM_WINDOW_TYPE_NOTIFICATION", True);
-  atoms.net_wm_toolbar =
-      XInternAtom(display, "_NET_WM_WINDOW_TYPE_TOOLBAR", True);
-  atoms.net_wm_hidden = XInternAtom(display, "_NET_WM_STATE_HIDDEN", False);
-  atoms.net_wm_popup_menu =
-      XInternAtom(display, "_NET_WM_WINDOW_TYPE_POPUP_MENU", False);
-  atoms.net_wm_normal =
-      XInternAtom(display, "_NET_WM_WINDOW_TYPE_NORMAL", True);
-
-  atoms.net_wm_utility =
-      XInternAtom(display, "_NET_WM_WINDOW_TYPE_UTILITY", False);
-
-  atoms.client_list = XInternAtom(display, "_NET_CLIENT_LIST", True);
-  atoms.client_list_stack =
-      XInternAtom(display, "_NET_CLIENT_LIST_STACKING", True);
-  atoms.num_of_desktop = XInternAtom(display, "_NET_NUMBER_OF_DESKTOPS", True);
-  atoms.net_curr_desktop = XInternAtom(display, "_NET_CURRENT_DESKTOP", True);
-  atoms.motif_wm_hints = XInternAtom(display, "_MOTIF_WM_HINTS", False);
-  atoms.net_wm_modal = XInternAtom(display, "_NET_WM_STATE_MODAL", False);
-  atoms.net_wm_skip_taskbar =
-      XInternAtom(display, "_NET_WM_STATE_SKIP_TASKBAR", False);
-  atoms.net_frame_extents = XInternAtom(display, "_NET_FRAME_EXTENTS", False);
-  atoms.gtk_frame_extents = XInternAtom(display, "_GTK_FRAME_EXTENTS", False);
-  atoms.net_moveresize_window =
-      XInternAtom(display, "_NET_MOVERESIZE_WINDOW", False);
-}
+typedef struct {
+  const char *name;
+  Atom *atom;
+  int only_if_exists;
+} gf_atom_entry;
+
+// Atoms interned with only_if_exists stay None until some client creates
+// them; they are looked up again once a newer atom shows up in an event.
+// Only property names qualify: PropertyNotify reports those, whereas values
+// such as window types first appear inside _NET_WM_STATE and would never
+// trigger the lookup, so those are created up front.
+static const gf_atom_entry atom_table[] = {
+    {"WM_STATE", &atoms.wm_state, False},
+    {"_NET_WM_STATE", &atoms.net_wm_state, False},
+    {"_NET_WM_STATE_MAXIMIZED_HORZ", &atoms.net_wm_max_horz, False},
+    {"_NET_WM_STATE_MAXIMIZED_VERT", &atoms.net_wm_max_vert, False},
+    {"_NET_WM_DESKTOP", &atoms.net_wm_desktop, True},
+    {"_NET_WM_WINDOW_TYPE", &atoms.net_wm_type, False},
+    {"_NET_WM_WINDOW_TYPE_TOOLTIP", &atoms.net_wm_tooltip, False},
+    {"_NET_WM_WINDOW_TYPE_NOTIFICATION", &atoms.net_wm_notification, False},
+    {"_NET_WM_WINDOW_TYPE_TOOLBAR", &atoms.net_wm_toolbar, False},
+    {"_NET_WM_STATE_HIDDEN", &atoms.net_wm_hidden, False},
+    {"_NET_WM_WINDOW_TYPE_POPUP_MENU", &atoms.net_wm_popup_menu, False},
+    {"_NET_WM_WINDOW_TYPE_NORMAL", &atoms.net_wm_normal, False},
+    {"_NET_WM_WINDOW_TYPE_UTILITY", &atoms.net_wm_utility, False},
+    {"_NET_CLIENT_LIST", &atoms.client_list, True},
+    {"_NET_CLIENT_LIST_STACKING", &atoms.client_list_stack, True},
+    {"_NET_NUMBER_OF_DESKTOPS", &atoms.num_of_desktop, True},
+    {"_NET_CURRENT_DESKTOP", &atoms.net_curr_desktop, True},
+    {"_NET_WORKAREA", &atoms.net_workarea, True},
+    {"_MOTIF_WM_HINTS", &atoms.motif_wm_hints, False},
+    {"_NET_WM_STATE_MODAL", &atoms.net_wm_modal, False},
+    {"_NET_WM_STATE_SKIP_TASKBAR", &atoms.net_wm_skip_taskbar, False},
+    {"_NET_FRAME_EXTENTS", &atoms.net_frame_extents, False},
+    {"_GTK_FRAME_EXTENTS", &atoms.gtk_frame_extents, False},
+    {"_NET_MOVERESIZE_WINDOW", &atoms.net_moveresize_window, False},
+    {"WM_PROTOCOLS", &atoms.wm_protocols, False},
+    {"_NET_WM_SYNC_REQUEST", &atoms.net_wm_sync_request, False},
+    {"_NET_WM_SYNC_REQUEST_COUNTER", &atoms.net_wm_sync_request_counter, False},
+};
+
+#define GF_ATOM_COUNT (sizeof(atom_table) / sizeof(atom_table[0]))
+
+static Atom newest_atom;
+static unsigned int unresolved_atoms;
 
-void gf_split_window_generic(void **windows, int window_count, int x, int y,
-                             int width, int height, int depth,
-                             gf_split_ctx *ctx) {
-  if (window_count <= 0)
-    return;
+// Sends every lookup before reading the first reply, so the whole table
+// costs one round trip. Returns how many atoms went from None to known.
+static int gf_intern_atoms(xcb_connection_t *conn, int missing_only) {
+  xcb_intern_atom_cookie_t cookies[GF_ATOM_COUNT];
+  int resolved = 0;
 
-  if (window_count == 1 && windows[0] != NULL && ctx->set_geometry != NULL) {
-    ctx->set_geometry(windows[0], x, y, width, height, ctx->user_data,
-                      ctx->session);
-    return;
+  for (size_t i = 0; i < GF_ATOM_COUNT; i++) {
+    if (missing_only && *atom_table[i].atom != None)
+      continue;
+
+    const char *name = atom_table[i].name;
+    cookies[i] =
+        xcb_intern_atom(conn, atom_table[i].only_if_exists, strlen(name), name);
+    gf_stats_request(GF_REQ_INTERN_ATOM, 0);
   }
+  gf_stats_round_trip();
+
+  unresolved_atoms = 0;
+  for (size_t i = 0; i < GF_ATOM_COUNT; i++) {
+    Atom *atom = atom_table[i].atom;
+    if (missing_only && *atom != None)
+      continue;
 
-  int split_vertically = depth % 2 == 0;
-  int left_count = window_count / 2;
-  int right_count = window_count - left_count;
-
-  if (split_vertically) {
-    int left_width = width / 2;
-    int right_width = width - left_width;
-
-    gf_split_window_generic(windows, left_count, x, y, left_width, height,
-                            depth + 1, ctx);
-    gf_split_window_generic(windows + left_count, right_count, x + left_width,
-                            y, right_width, height, depth + 1, ctx);
-  } else {
-    int top_height = height / 2;
-    int bottom_height = height - top_height;
-
-    gf_split_window_generic(windows, left_count, x, y, width, top_height,
-                            depth + 1, ctx);
-    gf_split_window_generic(windows + left_count, right_count, x,
-                            y + top_height, width, bottom_height, depth + 1,
-                            ctx);
+    xcb_intern_atom_reply_t *reply =
+        xcb_intern_atom_reply(conn, cookies[i], NULL);
+    if (reply && reply->atom != XCB_ATOM_NONE) {
+      *atom = reply->atom;
+      resolved++;
+      if (*atom > newest_atom)
+        newest_atom = *atom;
+    } else {
+      unresolved_atoms++;
+    }
+    free(reply);
   }
+
+  return resolved;
 }
 
-void gf_set_geometry(void *window_ptr, int x, int y, int width, int height,
-                     void *user_data, char *session) {
-  if (!window_ptr || !user_data) {
-    LOG(GF_ERR, " NULL Pointer detected \n");
-    return;
-  }
+void gf_init_atom(Display *display) {
+  memset(&atoms, 0, sizeof(atoms));
+  newest_atom = None;
+  gf_intern_atoms(XGetXCBConnection(display), 0);
+
+  if (unresolved_atoms)
+    LOG(GF_DBG, "%u atoms do not exist yet, resolving them on demand",
+        unresolved_atoms);
+}
+
+int gf_atom_seen(Display *display, Atom atom) {
+  // The server hands out atoms in increasing order: nothing newer than the
+  // last one we know means nothing we are missing can have been created
+  if (atom <= newest_atom)
+    return 0;
+
+  newest_atom = atom;
+  if (unresolved_atoms == 0)
+    return 0;
+
+  int resolved = gf_intern_atoms(XGetXCBConnection(display), 1);
+  if (resolved)
+    LOG(GF_DBG, "Resolved %d late atoms, %u still missing", resolved,
+        unresolved_atoms);
+  return resolved;
+}
+
+int gf_excluded_state(Atom state) {
+  const Atom excluded_states[] = {
+      atoms.net_wm_hidden,       atoms.net_wm_notification,
+      atoms.net_wm_popup_menu,   atoms.net_wm_tooltip,
+      atoms.net_wm_toolbar,      atoms.net_wm_modal,
+      atoms.net_wm_skip_taskbar, atoms.net_wm_utility};
 
-  if (strcmp(session, GF_X11) == 0) {
-    Display *display = (Display *)user_data;
-    Window window = *(Window *)window_ptr;
+  const size_t excluded_count =
+      sizeof(excluded_states) / sizeof(excluded_states[0]);
 
-    wm_x_set_geometry(display, window, StaticGravity,
-                      CHANGE_X | CHANGE_Y | CHANGE_WIDTH | CHANGE_HEIGHT |
-                          APPLY_PADDING,
-                      x, y, width, height);
+  for (size_t i = 0; i < excluded_count; i++) {
+    if (state != None && state == excluded_states[i])
+      return 1;
   }
+  return 0;
 }
@@ -31,15 +31,6 @@
 #define ERR_SEND_MSG_FAIL "Fail to send message"
 #define ERR_FAIL_ALLOCATE "Fail to allocate"
 
-typedef void (*gf_set_geometry_func)(void *window, int x, int y, int width,
-                                     int height, void *user_data, char *sess);
-
-typedef struct {
-  gf_set_geometry_func set_geometry;
-  void *user_data;
-  char *session;
-} gf_split_ctx;
-
 typedef struct {
   Atom wm_state;
   Atom net_wm_state;
@@ -59,6 +50,7 @@ typedef struct {
   Atom client_list_stack;
   Atom num_of_desktop;
   Atom net_curr_desktop;
+  Atom net_workarea;
 
   Atom motif_wm_hints;
   Atom net_wm_modal;
@@ -66,16 +58,16 @@ typedef struct {
   Atom gtk_frame_extents;
   Atom net_frame_extents;
   Atom net_moveresize_window;
+  Atom wm_protocols;
+  Atom net_wm_sync_request;
+  Atom net_wm_sync_request_counter;
 } gf_atom_type;
 
-void gf_set_geometry(void *window_ptr, int x, int y, int width, int height,
-                     void *user_data, char *session);
-
-void gf_split_window_generic(void **windows, int window_count, int x, int y,
-                             int width, int height, int depth,
-                             gf_split_ctx *ctx);
-
 extern gf_atom_type atoms;
 void gf_init_atom(Display *display);
+// Call with every atom an event carries; returns how many atoms that were
+// still None got resolved, which means cached state may be stale.
+int gf_atom_seen(Display *display, Atom atom);
+int gf_excluded_state(Atom state);
 
 #endif // GF_EWMH
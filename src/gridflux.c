@@ -18,17 +18,51 @@
  */
 
 #include "gridflux.h"
+#include "pipeline.h"
+#include "stats.h"
 #include "xwm.h"
 #include <stdlib.h>
 #include <string.h>
 
-int main() {
+static void gf_usage(const char *program) {
+  printf("Usage: %s [--stats] [--record FILE | --replay FILE]\n", program);
+  printf("  --stats         print X request and stage timing counters on exit\n");
+  printf("  --record FILE   write the observed X inputs to a binary trace\n");
+  printf("  --replay FILE   run a trace through the layout pipeline offline\n");
+  printf("Send SIGUSR1 to print the counters while running.\n");
+}
+
+int main(int argc, char **argv) {
+  int dump_stats = 0;
+  const char *record_path = NULL;
+  const char *replay_path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--stats") == 0) {
+      dump_stats = 1;
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      record_path = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replay_path = argv[++i];
+    } else {
+      gf_usage(argv[0]);
+      return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+    }
+  }
+
+  gf_log_init();
+  gf_stats_init(dump_stats);
+
+  // Replay needs no X server, only the recorded inputs
+  if (replay_path)
+    return gf_pipeline_replay(replay_path, stdout) < 0 ? 1 : 0;
+
 #ifdef __linux
   char *session_type = getenv("XDG_SESSION_TYPE");
   if (session_type != NULL) {
     if (strcmp(session_type, GF_X11) == 0) {
       LOG(GF_INFO, " X11 Session detected. \n");
-      wm_x_run_layout();
+      wm_x_run_layout(record_path);
     } else {
       printf("The session %s type is not supported.\n", session_type);
     }
@@ -19,6 +19,7 @@
 
 #ifndef GF_H
 #define GF_H
+#include "log.h"
 #include <stdio.h>
 #include <time.h>
 
@@ -27,7 +28,15 @@
 #define GF_INFO 3
 #define GF_DBG 4
 
-#define CURRENT_LOG_LEVEL GF_DBG
+// Levels above this are compiled out entirely; gf_log_level (set through
+// GRIDFLUX_LOG_LEVEL) filters the rest at runtime.
+#ifndef GF_LOG_COMPILE_LEVEL
+#ifdef DEBUG_MODE
+#define GF_LOG_COMPILE_LEVEL GF_DBG
+#else
+#define GF_LOG_COMPILE_LEVEL GF_INFO
+#endif
+#endif
 
 #define RED "\x1b[31m"
 #define YELLOW "\x1b[33m"
@@ -35,83 +44,14 @@
 #define BLUE "\x1b[34m"
 #define RESET "\x1b[0m"
 
-#ifdef DEBUG_MODE
 #define LOG(level, fmt, ...)                                                   \
   do {                                                                         \
-    if (level <= CURRENT_LOG_LEVEL) {                                          \
-      time_t rawtime;                                                          \
-      struct tm *timeinfo;                                                     \
-      char timeStr[20];                                                        \
-                                                                               \
-      time(&rawtime);                                                          \
-      timeinfo = localtime(&rawtime);                                          \
-      strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", timeinfo);       \
-                                                                               \
-      const char *color = RESET;                                               \
-      const char *level_str = "UNKNOWN";                                       \
-                                                                               \
-      switch (level) {                                                         \
-      case GF_ERR:                                                             \
-        color = RED;                                                           \
-        level_str = "ERROR";                                                   \
-        break;                                                                 \
-      case GF_WARN:                                                            \
-        color = YELLOW;                                                        \
-        level_str = "WARNING";                                                 \
-        break;                                                                 \
-      case GF_INFO:                                                            \
-        color = GREEN;                                                         \
-        level_str = "INFO";                                                    \
-        break;                                                                 \
-      case GF_DBG:                                                             \
-        color = BLUE;                                                          \
-        level_str = "DEBUG";                                                   \
-        break;                                                                 \
-      }                                                                        \
-                                                                               \
-      printf("%s[%s] [%s] [%s:%d] %s(): " fmt RESET "\n", color, timeStr,      \
-             level_str, __FILE__, __LINE__, __func__, ##__VA_ARGS__);          \
+    if ((level) <= GF_LOG_COMPILE_LEVEL && (level) <= gf_log_level) {          \
+      static gf_log_site gf_log_site_;                                         \
+      gf_log_write(&gf_log_site_, level, __FILE__, __LINE__, __func__, fmt,    \
+                   ##__VA_ARGS__);                                             \
     }                                                                          \
   } while (0)
-#else
-#define LOG(level, fmt, ...)                                                   \
-  do {                                                                         \
-    if (level <= CURRENT_LOG_LEVEL) {                                          \
-      time_t rawtime;                                                          \
-      struct tm *timeinfo;                                                     \
-      char timeStr[20];                                                        \
-                                                                               \
-      time(&rawtime);                                                          \
-      timeinfo = localtime(&rawtime);                                          \
-      strftime(timeStr, sizeof(timeStr), "%Y-%m-%d %H:%M:%S", timeinfo);       \
-                                                                               \
-      const char *color = RESET;                                               \
-      const char *level_str = "UNKNOWN";                                       \
-                                                                               \
-      switch (level) {                                                         \
-      case GF_ERR:                                                             \
-        color = RED;                                                           \
-        level_str = "ERROR";                                                   \
-        break;                                                                 \
-      case GF_WARN:                                                            \
-        color = YELLOW;                                                        \
-        level_str = "WARNING";                                                 \
-        break;                                                                 \
-      case GF_INFO:                                                            \
-        color = GREEN;                                                         \
-        level_str = "INFO";                                                    \
-        break;                                                                 \
-      case GF_DBG:                                                             \
-        color = BLUE;                                                          \
-        level_str = "DEBUG";                                                   \
-        break;                                                                 \
-      }                                                                        \
-                                                                               \
-      printf("%s[%s] [%s] %s(): " fmt RESET "\n", color, timeStr, level_str,   \
-             __func__, ##__VA_ARGS__);                                         \
-    }                                                                          \
-  } while (0)
-#endif
 
 #define GF_X11 "x11"
 
@@ -0,0 +1,56 @@
+#include "gridflux.h"
+#include "workspace.h"
+
+#ifdef GF_WITH_DBUS
+#include <dbus/dbus.h>
+
+static int gf_kwin_request(void *user_data, unsigned long current,
+                           unsigned long wanted) {
+  DBusConnection *conn = (DBusConnection *)user_data;
+
+  for (unsigned long position = current; position < wanted; position++) {
+    DBusMessage *message = dbus_message_new_method_call(
+        "org.kde.KWin", "/VirtualDesktopManager",
+        "org.kde.KWin.VirtualDesktopManager", "createDesktop");
+    if (!message)
+      return -1;
+
+    dbus_uint32_t index = (dbus_uint32_t)position;
+    const char *name = "gridflux";
+    dbus_message_append_args(message, DBUS_TYPE_UINT32, &index,
+                             DBUS_TYPE_STRING, &name, DBUS_TYPE_INVALID);
+
+    // Fire and forget, KWin announces the result via _NET_NUMBER_OF_DESKTOPS
+    dbus_message_set_no_reply(message, TRUE);
+    int sent = dbus_connection_send(conn, message, NULL);
+    dbus_message_unref(message);
+    if (!sent)
+      return -1;
+  }
+
+  dbus_connection_flush(conn);
+  return 0;
+}
+
+int gf_kwin_backend_init(gf_workspace_backend *backend) {
+  DBusError error;
+  dbus_error_init(&error);
+
+  DBusConnection *conn = dbus_bus_get(DBUS_BUS_SESSION, &error);
+  if (!conn) {
+    LOG(GF_WARN, "Session bus unavailable: %s", error.message);
+    dbus_error_free(&error);
+    return -1;
+  }
+
+  backend->name = "kwin";
+  backend->request = gf_kwin_request;
+  backend->user_data = conn;
+  return 0;
+}
+#else
+int gf_kwin_backend_init(gf_workspace_backend *backend) {
+  (void)backend;
+  return -1;
+}
+#endif
@@ -0,0 +1,685 @@
+#include "layout.h"
+#include "ewmh.h"
+#include "gridflux.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *layout_kind_names[GF_LAYOUT_KIND_COUNT] = {
+    [GF_LAYOUT_BSP] = "bsp",
+    [GF_LAYOUT_MASTER_STACK] = "master-stack",
+    [GF_LAYOUT_COLUMNS] = "columns",
+    [GF_LAYOUT_GRID] = "grid",
+};
+
+static gf_rect gf_layout_inset(gf_rect rect, int gap) {
+  rect.x += gap;
+  rect.y += gap;
+  rect.width = rect.width > gap * 2 ? rect.width - gap * 2 : rect.width;
+  rect.height = rect.height > gap * 2 ? rect.height - gap * 2 : rect.height;
+  return rect;
+}
+
+static int gf_layout_share(int length, float ratio) {
+  if (ratio <= 0.0f || ratio >= 1.0f)
+    ratio = 0.5f;
+  return (int)(length * ratio);
+}
+
+int gf_size_hints_fit(const gf_size_hints *hints, int vertical, int length) {
+  if (!hints)
+    return length;
+
+  int min = vertical ? hints->min_height : hints->min_width;
+  int max = vertical ? hints->max_height : hints->max_width;
+  int base = vertical ? hints->base_height : hints->base_width;
+  int inc = vertical ? hints->height_inc : hints->width_inc;
+
+  if (max > 0 && length > max)
+    length = max;
+  // Terminals and the like only take whole cells past their base size
+  if (inc > 1 && length > base)
+    length = base + (length - base) / inc * inc;
+  if (length < min)
+    length = min;
+  return length;
+}
+
+// Fits a tile rather than a window: the gap is inset afterwards
+static int gf_layout_fit(const gf_size_hints *hints, int vertical, int length,
+                         int gap) {
+  if (!hints || length <= gap * 2)
+    return length;
+  return gf_size_hints_fit(hints, vertical, length - gap * 2) + gap * 2;
+}
+
+// Gap inset and the last fit of one tile: whatever the split could not
+// absorb, the window itself still has to accept its size or it snaps back
+// and triggers another relayout
+static gf_rect gf_layout_tile(gf_rect area, int gap,
+                              const gf_size_hints *hints) {
+  gf_rect tile = gap > 0 ? gf_layout_inset(area, gap) : area;
+  if (hints) {
+    tile.width = gf_size_hints_fit(hints, 0, tile.width);
+    tile.height = gf_size_hints_fit(hints, 1, tile.height);
+  }
+  return tile;
+}
+
+// Cuts `area` in two along one axis and returns the length of the first
+// half. A side holding a lone window passes its hints, so that window
+// takes what it accepts and its sibling the rest.
+static int gf_layout_split(const gf_layout_params *params, gf_rect area,
+                           int vertical, float ratio,
+                           const gf_size_hints *first_hints,
+                           const gf_size_hints *second_hints,
+                           gf_rect halves[2]) {
+  int length = vertical ? area.height : area.width;
+  int gap = params->gap > 0 ? params->gap : 0;
+  int first = gf_layout_share(length, ratio);
+
+  if (first_hints)
+    first = gf_layout_fit(first_hints, vertical, first, gap);
+  else if (second_hints)
+    first = length - gf_layout_fit(second_hints, vertical, length - first, gap);
+  if (first > length)
+    first = length;
+
+  halves[0] = halves[1] = area;
+  if (!vertical) {
+    halves[0].width = first;
+    halves[1].x = area.x + first;
+    halves[1].width = area.width - first;
+  } else {
+    halves[0].height = first;
+    halves[1].y = area.y + first;
+    halves[1].height = area.height - first;
+  }
+  return first;
+}
+
+// Stateless BSP over a flat window list, alternating axes with depth
+static void gf_layout_bsp(const gf_layout_params *params, unsigned long count,
+                          gf_rect area, int depth, const gf_size_hints *hints,
+                          gf_rect *out) {
+  if (count == 0)
+    return;
+
+  if (count == 1) {
+    out[0] = area;
+    return;
+  }
+
+  unsigned long left_count = count / 2;
+  unsigned long right_count = count - left_count;
+  gf_rect halves[2];
+
+  // The outermost split honours the layout ratio, deeper ones stay even
+  gf_layout_split(params, area, depth % 2, depth == 0 ? params->ratio : 0.5f,
+                  hints && left_count == 1 ? &hints[0] : NULL,
+                  hints && right_count == 1 ? &hints[count - 1] : NULL,
+                  halves);
+  gf_layout_bsp(params, left_count, halves[0], depth + 1, hints, out);
+  gf_layout_bsp(params, right_count, halves[1], depth + 1,
+                hints ? hints + left_count : NULL, out + left_count);
+}
+
+static int gf_layout_tree_alloc(gf_layout_tree *tree) {
+  if (!tree->free) {
+    int capacity = tree->capacity ? tree->capacity * 2 : 16;
+    gf_layout_node *grown =
+        realloc(tree->nodes, capacity * sizeof(*tree->nodes));
+    if (!grown) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return 0;
+    }
+
+    // Node 0 stays reserved; chain the new ones lowest first
+    for (int i = capacity - 1; i >= (tree->capacity ? tree->capacity : 1);
+         i--) {
+      grown[i].leaves = 0;
+      grown[i].parent = tree->free;
+      tree->free = i;
+    }
+    tree->nodes = grown;
+    tree->capacity = capacity;
+  }
+
+  int node = tree->free;
+  tree->free = tree->nodes[node].parent;
+  memset(&tree->nodes[node], 0, sizeof(tree->nodes[node]));
+  return node;
+}
+
+static void gf_layout_tree_release(gf_layout_tree *tree, int node) {
+  tree->nodes[node].leaves = 0;
+  tree->nodes[node].parent = tree->free;
+  tree->free = node;
+}
+
+int gf_layout_tree_insert(gf_layout_tree *tree, Window window) {
+  int leaf = gf_layout_tree_alloc(tree);
+  if (!leaf)
+    return 0;
+
+  tree->nodes[leaf].window = window;
+  tree->nodes[leaf].leaves = 1;
+  if (!tree->root) {
+    tree->root = leaf;
+    return leaf;
+  }
+
+  int split = gf_layout_tree_alloc(tree);
+  if (!split) {
+    gf_layout_tree_release(tree, leaf);
+    return 0;
+  }
+
+  gf_layout_node *nodes = tree->nodes;
+  int target = tree->root;
+  while (nodes[target].leaves > 1) {
+    const int *child = nodes[target].child;
+    target = child[nodes[child[0]].leaves < nodes[child[1]].leaves ? 0 : 1];
+  }
+
+  // The split takes the target's place; the old window keeps the first half
+  int parent = nodes[target].parent;
+  nodes[split].parent = parent;
+  nodes[split].child[0] = target;
+  nodes[split].child[1] = leaf;
+  nodes[split].vertical = parent ? !nodes[parent].vertical : 0;
+  if (parent)
+    nodes[parent].child[nodes[parent].child[1] == target] = split;
+  else
+    tree->root = split;
+  nodes[target].parent = split;
+  nodes[leaf].parent = split;
+
+  nodes[split].leaves = 1;
+  for (int at = split; at; at = nodes[at].parent)
+    nodes[at].leaves++;
+  return leaf;
+}
+
+void gf_layout_tree_remove(gf_layout_tree *tree, int leaf) {
+  if (leaf <= 0 || leaf >= tree->capacity || tree->nodes[leaf].leaves != 1)
+    return;
+
+  gf_layout_node *nodes = tree->nodes;
+  int split = nodes[leaf].parent;
+  gf_layout_tree_release(tree, leaf);
+  if (!split) {
+    tree->root = 0;
+    return;
+  }
+
+  // Nothing outside the split moves: the sibling grows into its area
+  int sibling = nodes[split].child[nodes[split].child[0] == leaf];
+  int parent = nodes[split].parent;
+  nodes[sibling].parent = parent;
+  if (parent)
+    nodes[parent].child[nodes[parent].child[1] == split] = sibling;
+  else
+    tree->root = sibling;
+  gf_layout_tree_release(tree, split);
+
+  for (int at = parent; at; at = nodes[at].parent)
+    nodes[at].leaves--;
+}
+
+static int gf_layout_tree_split(const gf_layout_params *params,
+                                const gf_layout_tree *tree, int node,
+                                gf_rect area, gf_rect halves[2]) {
+  const gf_layout_node *split = &tree->nodes[node];
+  const gf_layout_node *first = &tree->nodes[split->child[0]];
+  const gf_layout_node *second = &tree->nodes[split->child[1]];
+  float ratio = split->ratio > 0.0f ? split->ratio
+                : split->parent    ? 0.5f
+                                   : params->ratio;
+
+  return gf_layout_split(params, area, split->vertical, ratio,
+                         first->leaves == 1 ? &first->hints : NULL,
+                         second->leaves == 1 ? &second->hints : NULL, halves);
+}
+
+// Area of any node, found by splitting its way down from the root
+static gf_rect gf_layout_tree_area(const gf_layout_params *params,
+                                   const gf_layout_tree *tree, gf_rect area,
+                                   int node) {
+  int parent = tree->nodes[node].parent;
+  if (!parent)
+    return area;
+
+  gf_rect halves[2];
+  gf_layout_tree_split(params, tree, parent,
+                       gf_layout_tree_area(params, tree, area, parent), halves);
+  return halves[tree->nodes[parent].child[1] == node];
+}
+
+static unsigned long gf_layout_tree_place(const gf_layout_params *params,
+                                          const gf_layout_tree *tree, int node,
+                                          gf_rect area, Window *windows,
+                                          gf_rect *out) {
+  const gf_layout_node *at = &tree->nodes[node];
+  if (at->leaves == 1) {
+    windows[0] = at->window;
+    out[0] = gf_layout_tile(area, params->gap, &at->hints);
+    return 1;
+  }
+
+  gf_rect halves[2];
+  gf_layout_tree_split(params, tree, node, area, halves);
+  unsigned long placed = gf_layout_tree_place(params, tree, at->child[0],
+                                              halves[0], windows, out);
+  return placed + gf_layout_tree_place(params, tree, at->child[1], halves[1],
+                                       windows + placed, out + placed);
+}
+
+unsigned long gf_layout_tree_compute(const gf_layout_params *params,
+                                     const gf_layout_tree *tree, gf_rect area,
+                                     Window *windows, gf_rect *out) {
+  if (!tree->root)
+    return 0;
+  return gf_layout_tree_place(params, tree, tree->root, area, windows, out);
+}
+
+unsigned long gf_layout_tree_compute_node(const gf_layout_params *params,
+                                          const gf_layout_tree *tree,
+                                          gf_rect area, int node,
+                                          Window *windows, gf_rect *out) {
+  if (node <= 0 || node >= tree->capacity || !tree->nodes[node].leaves)
+    return 0;
+  return gf_layout_tree_place(params, tree, node,
+                              gf_layout_tree_area(params, tree, area, node),
+                              windows, out);
+}
+
+int gf_layout_tree_resize(const gf_layout_params *params, gf_layout_tree *tree,
+                          gf_rect area, int leaf, int dw, int dh, int from_left,
+                          int from_top) {
+  if (params->kind != GF_LAYOUT_BSP || leaf <= 0 || leaf >= tree->capacity ||
+      tree->nodes[leaf].leaves != 1)
+    return 0;
+
+  // Deepest split on each axis with the leaf in its first or second half,
+  // i.e. the nodes owning the leaf's right/bottom and left/top edges
+  int edge[2][2] = {{0}};
+  for (int node = leaf; tree->nodes[node].parent;
+       node = tree->nodes[node].parent) {
+    const gf_layout_node *split = &tree->nodes[tree->nodes[node].parent];
+    int second = split->child[1] == node;
+    if (!edge[split->vertical][second])
+      edge[split->vertical][second] = tree->nodes[node].parent;
+  }
+
+  // Both owners are measured before either ratio moves
+  int deltas[2] = {dw, dh}, from_start[2] = {from_left, from_top};
+  int owners[2] = {0}, moved[2] = {0}, lengths[2] = {0};
+  for (int axis = 0; axis < 2; axis++) {
+    if (deltas[axis] == 0)
+      continue;
+
+    // Prefer the dragged edge; a tile at the border only has the other one
+    int second = from_start[axis];
+    if (!edge[axis][second])
+      second = !second;
+    if (!edge[axis][second])
+      continue;
+
+    gf_rect halves[2];
+    int owner = edge[axis][second];
+    gf_rect owner_area = gf_layout_tree_area(params, tree, area, owner);
+    int first = gf_layout_tree_split(params, tree, owner, owner_area, halves);
+
+    owners[axis] = owner;
+    moved[axis] = first + (second ? -deltas[axis] : deltas[axis]);
+    lengths[axis] = axis ? owner_area.height : owner_area.width;
+  }
+
+  // Both owners sit on the leaf's path, so the higher one holds the other
+  int changed = 0;
+  for (int axis = 0; axis < 2; axis++) {
+    if (!owners[axis] || lengths[axis] <= 0)
+      continue;
+
+    float ratio = (float)moved[axis] / lengths[axis];
+    if (ratio < GF_LAYOUT_MIN_RATIO)
+      ratio = GF_LAYOUT_MIN_RATIO;
+    if (ratio > GF_LAYOUT_MAX_RATIO)
+      ratio = GF_LAYOUT_MAX_RATIO;
+    tree->nodes[owners[axis]].ratio = ratio;
+    if (!changed ||
+        tree->nodes[owners[axis]].leaves > tree->nodes[changed].leaves)
+      changed = owners[axis];
+  }
+  return changed;
+}
+
+void gf_layout_tree_free(gf_layout_tree *tree) {
+  free(tree->nodes);
+  memset(tree, 0, sizeof(*tree));
+}
+
+static void gf_layout_stack(unsigned long count, gf_rect area, int vertical,
+                            int gap, const gf_size_hints *hints,
+                            gf_rect *out) {
+  int length = vertical ? area.height : area.width;
+
+  // Sizes are solved in the axis length; the axis position holds whether
+  // the window is pinned by its hints until the offsets are laid out
+  for (unsigned long i = 0; i < count; i++) {
+    out[i] = area;
+    // Spread the remainder over the leading tiles
+    int size = length / (int)count + ((int)i < length % (int)count);
+    *(vertical ? &out[i].height : &out[i].width) = size;
+    *(vertical ? &out[i].y : &out[i].x) = 0;
+  }
+
+  // Every round pins at least one window or stops
+  for (unsigned long round = 0; hints && round < count; round++) {
+    int leftover = length, pinned = 0, open = 0;
+
+    for (unsigned long i = 0; i < count; i++) {
+      int *size = vertical ? &out[i].height : &out[i].width;
+      int *settled = vertical ? &out[i].y : &out[i].x;
+
+      if (!*settled) {
+        int fitted = gf_layout_fit(&hints[i], vertical, *size, gap);
+        if (fitted != *size) {
+          *size = fitted;
+          *settled = 1;
+          pinned = 1;
+        }
+      }
+      leftover -= *size;
+      open += !*settled;
+    }
+    if (!pinned || open == 0 || leftover == 0)
+      break;
+
+    // Hand what the pinned windows could not use to the others
+    int part = leftover / open, rest = leftover % open;
+    int step = rest < 0 ? -1 : 1, given = 0;
+    for (unsigned long i = 0; i < count; i++) {
+      int *size = vertical ? &out[i].height : &out[i].width;
+      if (*(vertical ? &out[i].y : &out[i].x))
+        continue;
+
+      *size += part + (given++ < rest * step ? step : 0);
+      if (*size < 1)
+        *size = 1;
+    }
+  }
+
+  int offset = 0;
+  for (unsigned long i = 0; i < count; i++) {
+    if (vertical) {
+      out[i].y = area.y + offset;
+      offset += out[i].height;
+    } else {
+      out[i].x = area.x + offset;
+      offset += out[i].width;
+    }
+  }
+}
+
+static void gf_layout_master_stack(unsigned long count, gf_rect area,
+                                   float ratio, int gap,
+                                   const gf_size_hints *hints, gf_rect *out) {
+  if (count == 1) {
+    out[0] = area;
+    return;
+  }
+
+  gf_rect master = area, stack = area;
+  master.width = gf_layout_share(area.width, ratio);
+  if (hints)
+    master.width = gf_layout_fit(&hints[0], 0, master.width, gap);
+  if (master.width > area.width)
+    master.width = area.width;
+  stack.x = area.x + master.width;
+  stack.width = area.width - master.width;
+
+  out[0] = master;
+  gf_layout_stack(count - 1, stack, 1, gap, hints ? hints + 1 : NULL,
+                  out + 1);
+}
+
+static void gf_layout_grid(unsigned long count, gf_rect area, int gap,
+                           const gf_size_hints *hints, gf_rect *out) {
+  unsigned long cols = 1;
+  while (cols * cols < count)
+    cols++;
+  unsigned long rows = (count + cols - 1) / cols;
+
+  gf_rect row_area = area;
+  unsigned long placed = 0;
+
+  for (unsigned long row = 0; row < rows; row++) {
+    row_area.y = area.y + (int)(area.height * row / rows);
+    row_area.height =
+        area.y + (int)(area.height * (row + 1) / rows) - row_area.y;
+
+    // The last row stretches its tiles over the full width
+    unsigned long in_row = count - placed < cols ? count - placed : cols;
+    gf_layout_stack(in_row, row_area, 0, gap, hints ? hints + placed : NULL,
+                    out + placed);
+    placed += in_row;
+  }
+}
+
+void gf_layout_compute(const gf_layout_params *params, unsigned long count,
+                       gf_rect area, const gf_size_hints *hints, gf_rect *out) {
+  if (count == 0)
+    return;
+
+  int gap = params->gap > 0 ? params->gap : 0;
+  switch (params->kind) {
+  case GF_LAYOUT_MASTER_STACK:
+    gf_layout_master_stack(count, area, params->ratio, gap, hints, out);
+    break;
+  case GF_LAYOUT_COLUMNS:
+    gf_layout_stack(count, area, 0, gap, hints, out);
+    break;
+  case GF_LAYOUT_GRID:
+    gf_layout_grid(count, area, gap, hints, out);
+    break;
+  case GF_LAYOUT_BSP:
+  default:
+    gf_layout_bsp(params, count, area, 0, hints, out);
+    break;
+  }
+
+  for (unsigned long i = 0; i < count; i++)
+    out[i] = gf_layout_tile(out[i], gap, hints ? &hints[i] : NULL);
+}
+
+gf_layout_kind gf_layout_kind_from_name(const char *name) {
+  for (int i = 0; i < GF_LAYOUT_KIND_COUNT; i++) {
+    if (strcmp(name, layout_kind_names[i]) == 0)
+      return (gf_layout_kind)i;
+  }
+  return GF_LAYOUT_KIND_COUNT;
+}
+
+const char *gf_layout_kind_name(gf_layout_kind kind) {
+  if (kind < 0 || kind >= GF_LAYOUT_KIND_COUNT)
+    return "unknown";
+  return layout_kind_names[kind];
+}
+
+void gf_layout_table_init(gf_layout_table *table, gf_layout_params fallback) {
+  table->params = NULL;
+  table->count = 0;
+  table->fallback = fallback;
+}
+
+int gf_layout_table_set(gf_layout_table *table, int workspace,
+                        gf_layout_params params) {
+  if (workspace < 0 || workspace >= GF_LAYOUT_MAX_WORKSPACES)
+    return -1;
+
+  if (workspace >= table->count) {
+    gf_layout_params *grown =
+        realloc(table->params, ((size_t)workspace + 1) * sizeof(*grown));
+    if (!grown) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return -1;
+    }
+    for (int i = table->count; i < workspace; i++)
+      grown[i] = table->fallback;
+    table->params = grown;
+    table->count = workspace + 1;
+  }
+
+  table->params[workspace] = params;
+  return 0;
+}
+
+const gf_layout_params *gf_layout_table_get(const gf_layout_table *table,
+                                            int workspace) {
+  if (workspace < 0 || workspace >= table->count)
+    return &table->fallback;
+  return &table->params[workspace];
+}
+
+int gf_layout_table_parse(gf_layout_table *table, const char *spec) {
+  char name[32];
+  int workspace = 0;
+
+  // Comma separated kinds, one per workspace: "bsp,grid,master-stack"
+  while (spec && *spec) {
+    size_t length = strcspn(spec, ",");
+    if (length >= sizeof(name)) {
+      LOG(GF_WARN, "Layout name too long for workspace %d", workspace);
+      return -1;
+    }
+
+    memcpy(name, spec, length);
+    name[length] = '\0';
+
+    gf_layout_params params = table->fallback;
+    if (length > 0) {
+      params.kind = gf_layout_kind_from_name(name);
+      if (params.kind == GF_LAYOUT_KIND_COUNT) {
+        LOG(GF_WARN, "Unknown layout '%s' for workspace %d", name, workspace);
+        return -1;
+      }
+    }
+
+    if (gf_layout_table_set(table, workspace, params) < 0)
+      return -1;
+
+    workspace++;
+    spec += length;
+    if (*spec == ',')
+      spec++;
+  }
+
+  return 0;
+}
+
+void gf_layout_table_free(gf_layout_table *table) {
+  free(table->params);
+  table->params = NULL;
+  table->count = 0;
+}
+
+void gf_layout_plan_reset(gf_layout_plan *plan) { plan->count = 0; }
+
+int gf_layout_plan_reserve(gf_layout_plan *plan, unsigned long count) {
+  if (count <= plan->capacity)
+    return 0;
+
+  unsigned long capacity = plan->capacity ? plan->capacity : 16;
+  while (capacity < count)
+    capacity *= 2;
+
+  Window *windows = realloc(plan->windows, capacity * sizeof(*windows));
+  if (windows)
+    plan->windows = windows;
+  gf_rect *rects = realloc(plan->rects, capacity * sizeof(*rects));
+  if (rects)
+    plan->rects = rects;
+
+  if (!windows || !rects) {
+    LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+    return -1;
+  }
+
+  plan->capacity = capacity;
+  return 0;
+}
+
+void gf_layout_plan_free(gf_layout_plan *plan) {
+  free(plan->windows);
+  free(plan->rects);
+  memset(plan, 0, sizeof(*plan));
+}
+
+int gf_rect_equal(gf_rect a, gf_rect b) {
+  return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+void gf_layout_schedule_mark_outputs(gf_layout_schedule *schedule,
+                                     long workspace, unsigned int outputs) {
+  if (workspace < 0 || workspace >= GF_LAYOUT_MAX_WORKSPACES || outputs == 0)
+    return;
+
+  if (workspace >= schedule->capacity) {
+    int capacity = schedule->capacity ? schedule->capacity : 8;
+    while (capacity <= workspace)
+      capacity *= 2;
+
+    unsigned int *dirty =
+        realloc(schedule->dirty, (size_t)capacity * sizeof(*schedule->dirty));
+    if (!dirty) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return;
+    }
+    memset(dirty + schedule->capacity, 0,
+           (size_t)(capacity - schedule->capacity) * sizeof(*dirty));
+    schedule->dirty = dirty;
+    schedule->capacity = capacity;
+  }
+
+  schedule->dirty[workspace] |= outputs;
+  schedule->pending = 1;
+}
+
+void gf_layout_schedule_mark(gf_layout_schedule *schedule, long workspace) {
+  gf_layout_schedule_mark_outputs(schedule, workspace, GF_LAYOUT_ALL_OUTPUTS);
+}
+
+void gf_layout_schedule_mark_all(gf_layout_schedule *schedule,
+                                 int workspace_count) {
+  for (int i = 0; i < workspace_count; i++)
+    gf_layout_schedule_mark(schedule, i);
+}
+
+unsigned int gf_layout_schedule_peek(const gf_layout_schedule *schedule,
+                                     long workspace) {
+  if (workspace < 0 || workspace >= schedule->capacity)
+    return 0;
+  return schedule->dirty[workspace];
+}
+
+unsigned int gf_layout_schedule_take(gf_layout_schedule *schedule,
+                                     int workspace) {
+  if (workspace < 0 || workspace >= schedule->capacity)
+    return 0;
+
+  unsigned int outputs = schedule->dirty[workspace];
+  schedule->dirty[workspace] = 0;
+  return outputs;
+}
+
+void gf_layout_schedule_clear(gf_layout_schedule *schedule) {
+  if (schedule->dirty)
+    memset(schedule->dirty, 0, schedule->capacity * sizeof(*schedule->dirty));
+  schedule->pending = 0;
+}
+
+void gf_layout_schedule_free(gf_layout_schedule *schedule) {
+  free(schedule->dirty);
+  memset(schedule, 0, sizeof(*schedule));
+}
@@ -0,0 +1,180 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_LAYOUT
+#define GF_LAYOUT
+
+#include <X11/X.h>
+
+#define GF_LAYOUT_DEFAULT_GAP 6
+
+typedef struct {
+  int x;
+  int y;
+  int width;
+  int height;
+} gf_rect;
+
+// WM_NORMAL_HINTS as the solver sees it: sizes a window accepts are
+// base + k * inc within [min, max]. Zero means unconstrained; `gravity` is
+// only carried along for the X backend and ignored by the layouts.
+typedef struct {
+  int min_width;
+  int min_height;
+  int max_width;
+  int max_height;
+  int base_width;
+  int base_height;
+  int width_inc;
+  int height_inc;
+  int gravity;
+} gf_size_hints;
+
+typedef enum {
+  GF_LAYOUT_BSP,
+  GF_LAYOUT_MASTER_STACK,
+  GF_LAYOUT_COLUMNS,
+  GF_LAYOUT_GRID,
+  GF_LAYOUT_KIND_COUNT
+} gf_layout_kind;
+
+typedef struct {
+  gf_layout_kind kind;
+  int gap;     // inset applied to every side of each tile
+  float ratio; // share of the first split (BSP) or of the master column
+} gf_layout_params;
+
+// One node of a persistent BSP. A leaf holds a window and the hints the
+// solver fits its tile to; a split gives `ratio` of its width (or height
+// when `vertical`) to child[0] and the rest to child[1]. Node 0 is never
+// used, so 0 reads as "no node" and a zeroed tree is empty.
+typedef struct {
+  Window window;
+  gf_size_hints hints;
+  int parent;
+  int child[2];
+  unsigned long leaves; // tiles below the node, 0 while it is free
+  float ratio;          // 0 falls back to the layout ratio at the root, or 0.5
+  int vertical;
+} gf_layout_node;
+
+// Kept across passes so a window opening splits one tile and one closing
+// hands its space to its sibling, instead of every tile moving.
+typedef struct {
+  gf_layout_node *nodes;
+  int capacity;
+  int root;
+  int free; // free nodes, chained through `parent`
+} gf_layout_tree;
+
+#define GF_LAYOUT_MIN_RATIO 0.05f
+#define GF_LAYOUT_MAX_RATIO 0.95f
+
+// Per-workspace layout selection, workspaces past `count` use `fallback`.
+typedef struct {
+  gf_layout_params *params;
+  int count;
+  gf_layout_params fallback;
+} gf_layout_table;
+
+// Target rectangles for one layout pass, applied by the commit stage.
+typedef struct {
+  Window *windows;
+  gf_rect *rects;
+  unsigned long count;
+  unsigned long capacity;
+} gf_layout_plan;
+
+#define GF_LAYOUT_MAX_OUTPUTS 32
+// Bounds every per-workspace table; desktops beyond it are never laid out
+#define GF_LAYOUT_MAX_WORKSPACES 1024
+#define GF_LAYOUT_ALL_OUTPUTS (~0u)
+
+// Workspaces waiting for a relayout, as a mask of dirty outputs each.
+// Triggers within one event batch only set bits, so each dirty output of a
+// workspace is laid out once per batch.
+typedef struct {
+  unsigned int *dirty;
+  int capacity;
+  int pending;
+} gf_layout_schedule;
+
+// Writes `count` rectangles tiling `area` into `out`. With `hints` (one
+// per window, may be NULL) every rect is a size its window accepts and the
+// space a constrained window cannot use goes to its siblings. Pure: no
+// heap, no callbacks and no X requests, so it is safe to run on every event.
+void gf_layout_compute(const gf_layout_params *params, unsigned long count,
+                       gf_rect area, const gf_size_hints *hints, gf_rect *out);
+
+// Adds `window` by splitting the leaf on the side with fewer tiles, which
+// keeps the tree about log2(n) deep. Returns its leaf, or 0 without memory.
+int gf_layout_tree_insert(gf_layout_tree *tree, Window window);
+// Drops a leaf; its sibling takes over the area of their parent split.
+void gf_layout_tree_remove(gf_layout_tree *tree, int leaf);
+// Lays the tree out over `area` like gf_layout_compute does for BSP,
+// writing each leaf's window and rect in tree order. Returns the tile count.
+unsigned long gf_layout_tree_compute(const gf_layout_params *params,
+                                     const gf_layout_tree *tree, gf_rect area,
+                                     Window *windows, gf_rect *out);
+// Same for the leaves below `node` only, at the place the whole tree would
+// give them; `out` needs room for nodes[node].leaves tiles.
+unsigned long gf_layout_tree_compute_node(const gf_layout_params *params,
+                                          const gf_layout_tree *tree,
+                                          gf_rect area, int node,
+                                          Window *windows, gf_rect *out);
+// Turns a user resize of `leaf` by (dw, dh) into a new ratio for the split
+// owning the dragged edge: the right or bottom one unless `from_left` /
+// `from_top` says otherwise. Returns the highest split it changed, the only
+// subtree whose tiles move, or 0 when no split could absorb it.
+int gf_layout_tree_resize(const gf_layout_params *params, gf_layout_tree *tree,
+                          gf_rect area, int leaf, int dw, int dh, int from_left,
+                          int from_top);
+void gf_layout_tree_free(gf_layout_tree *tree);
+int gf_size_hints_fit(const gf_size_hints *hints, int vertical, int length);
+
+gf_layout_kind gf_layout_kind_from_name(const char *name);
+const char *gf_layout_kind_name(gf_layout_kind kind);
+
+void gf_layout_table_init(gf_layout_table *table, gf_layout_params fallback);
+int gf_layout_table_set(gf_layout_table *table, int workspace,
+                        gf_layout_params params);
+const gf_layout_params *gf_layout_table_get(const gf_layout_table *table,
+                                            int workspace);
+int gf_layout_table_parse(gf_layout_table *table, const char *spec);
+void gf_layout_table_free(gf_layout_table *table);
+
+void gf_layout_plan_reset(gf_layout_plan *plan);
+int gf_layout_plan_reserve(gf_layout_plan *plan, unsigned long count);
+void gf_layout_plan_free(gf_layout_plan *plan);
+
+int gf_rect_equal(gf_rect a, gf_rect b);
+
+void gf_layout_schedule_mark(gf_layout_schedule *schedule, long workspace);
+void gf_layout_schedule_mark_outputs(gf_layout_schedule *schedule,
+                                     long workspace, unsigned int outputs);
+void gf_layout_schedule_mark_all(gf_layout_schedule *schedule,
+                                 int workspace_count);
+unsigned int gf_layout_schedule_peek(const gf_layout_schedule *schedule,
+                                     long workspace);
+unsigned int gf_layout_schedule_take(gf_layout_schedule *schedule,
+                                     int workspace);
+void gf_layout_schedule_clear(gf_layout_schedule *schedule);
+void gf_layout_schedule_free(gf_layout_schedule *schedule);
+
+#endif // GF_LAYOUT
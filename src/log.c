@@ -0,0 +1,256 @@
+#include "log.h"
+#include "gridflux.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+typedef struct {
+  unsigned long sequence;
+  int level;
+  int line;
+  const char *file;
+  const char *func;
+  time_t second;
+  char message[GF_LOG_MESSAGE_SIZE];
+} gf_log_record;
+
+#ifdef DEBUG_MODE
+int gf_log_level = GF_DBG;
+#else
+int gf_log_level = GF_INFO;
+#endif
+
+// Bounded multi-producer queue: a producer claims a slot by advancing
+// `tail`, fills it and publishes it through the slot's sequence number.
+static gf_log_record ring[GF_LOG_RING_SIZE];
+static unsigned long tail;
+static unsigned long head;
+static unsigned long dropped;
+
+static pthread_t writer;
+static int writer_running;
+static int stopping;
+
+// An idle writer sleeps in read() on this pipe until a record arrives
+static int wake_pipe[2] = {-1, -1};
+static int writer_idle;
+
+static time_t cached_second = -1;
+static char cached_time[20];
+
+static const char *level_names[] = {
+    [GF_ERR] = "ERROR", [GF_WARN] = "WARNING", [GF_INFO] = "INFO",
+    [GF_DBG] = "DEBUG"};
+static const char *level_colors[] = {
+    [GF_ERR] = RED, [GF_WARN] = YELLOW, [GF_INFO] = GREEN, [GF_DBG] = BLUE};
+
+int gf_log_level_from_name(const char *name) {
+  for (int level = GF_ERR; level <= GF_DBG; level++) {
+    if (strcasecmp(name, level_names[level]) == 0)
+      return level;
+  }
+  if (strcasecmp(name, "error") == 0 || strcasecmp(name, "err") == 0)
+    return GF_ERR;
+  if (strcasecmp(name, "warn") == 0)
+    return GF_WARN;
+  if (strcasecmp(name, "dbg") == 0)
+    return GF_DBG;
+  return -1;
+}
+
+static void gf_log_print(const gf_log_record *record) {
+  // One strftime per second at most, the writer is the only caller
+  if (record->second != cached_second) {
+    struct tm timeinfo;
+    localtime_r(&record->second, &timeinfo);
+    strftime(cached_time, sizeof(cached_time), "%Y-%m-%d %H:%M:%S",
+             &timeinfo);
+    cached_second = record->second;
+  }
+
+  int level = record->level >= GF_ERR && record->level <= GF_DBG
+                  ? record->level
+                  : GF_DBG;
+#ifdef DEBUG_MODE
+  printf("%s[%s] [%s] [%s:%d] %s(): %s" RESET "\n", level_colors[level],
+         cached_time, level_names[level], record->file, record->line,
+         record->func, record->message);
+#else
+  printf("%s[%s] [%s] %s(): %s" RESET "\n", level_colors[level], cached_time,
+         level_names[level], record->func, record->message);
+#endif
+}
+
+static int gf_log_drain(void) {
+  int drained = 0;
+
+  for (;;) {
+    gf_log_record *record = &ring[head & (GF_LOG_RING_SIZE - 1)];
+    if (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) != head + 1)
+      break;
+
+    gf_log_print(record);
+    __atomic_store_n(&record->sequence, head + GF_LOG_RING_SIZE,
+                     __ATOMIC_RELEASE);
+    head++;
+    drained++;
+  }
+
+  unsigned long lost = __atomic_exchange_n(&dropped, 0, __ATOMIC_RELAXED);
+  if (lost)
+    printf(YELLOW "[%s] [WARNING] log ring full, dropped %lu records" RESET
+                  "\n",
+           cached_time, lost);
+  if (drained || lost)
+    fflush(stdout);
+  return drained;
+}
+
+// Producers call this after publishing; only the first one to find the
+// writer idle pays for the write().
+static void gf_log_wake(void) {
+  char byte = 0;
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_exchange_n(&writer_idle, 0, __ATOMIC_ACQ_REL))
+    (void)!write(wake_pipe[1], &byte, 1);
+}
+
+static void *gf_log_writer(void *arg) {
+  char buffer[64];
+  (void)arg;
+
+  while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+    if (gf_log_drain())
+      continue;
+
+    // Announce the sleep, then look once more: a record published before
+    // a producer could see the flag is drained here instead of waiting
+    __atomic_store_n(&writer_idle, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (gf_log_drain() ||
+        __atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+      __atomic_store_n(&writer_idle, 0, __ATOMIC_RELAXED);
+      continue;
+    }
+    if (read(wake_pipe[0], buffer, sizeof(buffer)) < 0 && errno != EINTR)
+      break;
+  }
+  return NULL;
+}
+
+void gf_log_init(void) {
+  for (unsigned long i = 0; i < GF_LOG_RING_SIZE; i++)
+    ring[i].sequence = i;
+
+  const char *name = getenv("GRIDFLUX_LOG_LEVEL");
+  int level = name ? gf_log_level_from_name(name) : -1;
+  if (level > 0)
+    gf_log_level = level;
+
+  if (pipe(wake_pipe) < 0)
+    return;
+  fcntl(wake_pipe[0], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_pipe[1], F_SETFD, FD_CLOEXEC);
+  fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+
+  // Signals stay with the X thread, whose poll they have to interrupt
+  sigset_t all, previous;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &previous);
+  int error = pthread_create(&writer, NULL, gf_log_writer, NULL);
+  pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+  if (error == 0) {
+    writer_running = 1;
+    atexit(gf_log_shutdown);
+  }
+}
+
+void gf_log_shutdown(void) {
+  if (!writer_running)
+    return;
+
+  __atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&writer_idle, 1, __ATOMIC_RELAXED);
+  gf_log_wake();
+  pthread_join(writer, NULL);
+  writer_running = 0;
+  gf_log_drain();
+}
+
+static gf_log_record *gf_log_claim(void) {
+  unsigned long position = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+
+  for (;;) {
+    gf_log_record *record = &ring[position & (GF_LOG_RING_SIZE - 1)];
+    long diff = (long)(__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) -
+                       position);
+
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&tail, &position, position + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        return record;
+    } else if (diff < 0) {
+      // The writer is behind; drop rather than block the event loop
+      __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+      gf_log_wake();
+      return NULL;
+    } else {
+      position = __atomic_load_n(&tail, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+void gf_log_write(gf_log_site *site, int level, const char *file, int line,
+                  const char *func, const char *fmt, ...) {
+  time_t now = time(NULL);
+  unsigned int suppressed = 0;
+
+  // A storm from one call site collapses into a count on its next record
+  if (__atomic_load_n(&site->second, __ATOMIC_RELAXED) != now) {
+    __atomic_store_n(&site->second, now, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->emitted, 0, __ATOMIC_RELAXED);
+    suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+  }
+  if (__atomic_fetch_add(&site->emitted, 1, __ATOMIC_RELAXED) >=
+      GF_LOG_BURST) {
+    __atomic_fetch_add(&site->suppressed, 1, __ATOMIC_RELAXED);
+    return;
+  }
+
+  gf_log_record local;
+  gf_log_record *record = writer_running ? gf_log_claim() : &local;
+  if (!record)
+    return;
+
+  record->level = level;
+  record->file = file;
+  record->line = line;
+  record->func = func;
+  record->second = now;
+
+  va_list args;
+  va_start(args, fmt);
+  int length = vsnprintf(record->message, sizeof(record->message), fmt, args);
+  va_end(args);
+
+  if (suppressed && length >= 0 && (size_t)length < sizeof(record->message))
+    snprintf(record->message + length, sizeof(record->message) - length,
+             " (%u similar suppressed)", suppressed);
+
+  if (record == &local) {
+    gf_log_print(record);
+    return;
+  }
+
+  unsigned long position = record->sequence;
+  __atomic_store_n(&record->sequence, position + 1, __ATOMIC_RELEASE);
+  gf_log_wake();
+}
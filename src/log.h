@@ -0,0 +1,48 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_LOG
+#define GF_LOG
+
+#define GF_LOG_RING_SIZE 256 // records, must be a power of two
+#define GF_LOG_MESSAGE_SIZE 240
+#define GF_LOG_BURST 5 // records per call site per second before suppressing
+
+// Per call site rate limit state, one static instance per LOG expansion.
+typedef struct {
+  long second;
+  unsigned int emitted;
+  unsigned int suppressed;
+} gf_log_site;
+
+extern int gf_log_level;
+
+// Starts the writer thread. Until then, and after gf_log_shutdown, records
+// are written synchronously so early errors and exit paths are not lost.
+void gf_log_init(void);
+void gf_log_shutdown(void);
+int gf_log_level_from_name(const char *name);
+
+// Formats on the caller's thread and queues the record without locking or
+// blocking; the writer thread adds the timestamp and does the I/O.
+void gf_log_write(gf_log_site *site, int level, const char *file, int line,
+                  const char *func, const char *fmt, ...)
+    __attribute__((format(printf, 6, 7)));
+
+#endif // GF_LOG
@@ -0,0 +1,837 @@
+#include "pipeline.h"
+#include "ewmh.h"
+#include "gridflux.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void gf_pipeline_record(gf_pipeline *pipeline,
+                               gf_trace_record record) {
+  if (pipeline->trace)
+    gf_trace_write(pipeline->trace, &record);
+}
+
+int gf_pipeline_init(gf_pipeline *pipeline, gf_pipeline_backend backend,
+                     gf_workspace_backend workspaces, gf_rect area,
+                     const char *layouts) {
+  memset(pipeline, 0, sizeof(*pipeline));
+  if (gf_client_table_init(&pipeline->clients, 0) < 0)
+    return -1;
+
+  gf_layout_table_init(&pipeline->layouts,
+                       (gf_layout_params){.kind = GF_LAYOUT_BSP,
+                                          .gap = GF_LAYOUT_DEFAULT_GAP,
+                                          .ratio = 0.5f});
+  gf_layout_table_parse(&pipeline->layouts, layouts);
+  gf_workspace_provisioner_init(&pipeline->provisioner, workspaces);
+
+  pipeline->backend = backend;
+  pipeline->outputs[0] = area;
+  pipeline->output_count = 1;
+  pipeline->max_windows = GF_PIPELINE_MAX_WINDOWS;
+  pipeline->sync_timeout_ns = GF_PIPELINE_SYNC_TIMEOUT_MS * 1000000ULL;
+  return 0;
+}
+
+static gf_layout_tree *gf_pipeline_tree(gf_pipeline *pipeline, long workspace,
+                                        int output, int create) {
+  if (workspace < 0 || workspace >= GF_LAYOUT_MAX_WORKSPACES || output < 0 ||
+      output >= GF_LAYOUT_MAX_OUTPUTS)
+    return NULL;
+
+  if (workspace >= pipeline->tree_workspaces) {
+    if (!create)
+      return NULL;
+
+    int count = pipeline->tree_workspaces ? pipeline->tree_workspaces : 4;
+    while (count <= workspace)
+      count *= 2;
+
+    gf_layout_tree *trees =
+        realloc(pipeline->trees, (size_t)count * GF_LAYOUT_MAX_OUTPUTS *
+                                     sizeof(*pipeline->trees));
+    if (!trees) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return NULL;
+    }
+    // A zeroed tree is an empty one
+    memset(trees + pipeline->tree_workspaces * GF_LAYOUT_MAX_OUTPUTS, 0,
+           (count - pipeline->tree_workspaces) * GF_LAYOUT_MAX_OUTPUTS *
+               sizeof(*trees));
+    pipeline->trees = trees;
+    pipeline->tree_workspaces = count;
+  }
+
+  return &pipeline->trees[workspace * GF_LAYOUT_MAX_OUTPUTS + output];
+}
+
+// What the client table's `leaf` column calls this tree
+static int gf_pipeline_tree_id(const gf_pipeline *pipeline,
+                               const gf_layout_tree *tree) {
+  return (int)(tree - pipeline->trees) + 1;
+}
+
+void gf_pipeline_free(gf_pipeline *pipeline) {
+  for (int i = 0; i < pipeline->tree_workspaces * GF_LAYOUT_MAX_OUTPUTS; i++)
+    gf_layout_tree_free(&pipeline->trees[i]);
+  free(pipeline->trees);
+
+  gf_client_table_free(&pipeline->clients);
+  gf_workspace_snapshot_free(&pipeline->snapshot);
+  gf_layout_schedule_free(&pipeline->schedule);
+  gf_layout_table_free(&pipeline->layouts);
+  gf_arena_free(&pipeline->arena);
+}
+
+int gf_pipeline_parse_max_windows(const char *value) {
+  if (!value || !*value)
+    return GF_PIPELINE_MAX_WINDOWS;
+  if (strcmp(value, "unlimited") == 0)
+    return GF_PIPELINE_UNLIMITED;
+
+  char *end;
+  long max_windows = strtol(value, &end, 10);
+  if (*end != '\0' || max_windows < 0 || max_windows > 1L << 20) {
+    LOG(GF_WARN, "Ignoring window limit '%s', using %d", value,
+        GF_PIPELINE_MAX_WINDOWS);
+    return GF_PIPELINE_MAX_WINDOWS;
+  }
+  return (int)max_windows;
+}
+
+unsigned long long gf_pipeline_parse_sync_timeout(const char *value) {
+  unsigned long long fallback = GF_PIPELINE_SYNC_TIMEOUT_MS * 1000000ULL;
+  if (!value || !*value)
+    return fallback;
+
+  char *end;
+  long timeout_ms = strtol(value, &end, 10);
+  if (*end != '\0' || timeout_ms < 0 || timeout_ms > 60000) {
+    LOG(GF_WARN, "Ignoring sync timeout '%s', using %d ms", value,
+        GF_PIPELINE_SYNC_TIMEOUT_MS);
+    return fallback;
+  }
+  return (unsigned long long)timeout_ms * 1000000ULL;
+}
+
+// Schedules the workspace a window leaves and drops its pending sync
+static void gf_pipeline_forget(void *user_data, gf_client_table *clients,
+                               unsigned long index) {
+  gf_pipeline *pipeline = user_data;
+
+  gf_layout_schedule_mark(&pipeline->schedule, clients->desktop[index]);
+  if (clients->flags[index] & GF_CLIENT_SYNCING)
+    pipeline->syncing--;
+}
+
+unsigned long gf_pipeline_sync_clients(gf_pipeline *pipeline,
+                                       const Window *windows,
+                                       unsigned long count) {
+  gf_pipeline_record(pipeline,
+                     (gf_trace_record){.type = GF_TRACE_CLIENT_LIST,
+                                       .windows = (Window *)windows,
+                                       .count = count});
+
+  return gf_client_table_sync(&pipeline->clients, windows, count,
+                              gf_pipeline_forget, pipeline);
+}
+
+void gf_pipeline_client_changed(gf_pipeline *pipeline, unsigned long index,
+                                long previous_desktop) {
+  gf_client_table *clients = &pipeline->clients;
+
+  // Unpaced sessions record no sync answers, so replays must not wait
+  if (!pipeline->sync_timeout_ns)
+    clients->flags[index] &= ~GF_CLIENT_SYNC;
+
+  gf_pipeline_record(pipeline, (gf_trace_record){
+                                   .type = GF_TRACE_CLIENT,
+                                   .window = clients->id[index],
+                                   .value = clients->desktop[index],
+                                   .flags = clients->flags[index],
+                                   .rect = clients->geometry[index],
+                               });
+  static const gf_size_hints no_hints;
+  if (memcmp(&clients->hints[index], &no_hints, sizeof(no_hints)) != 0)
+    gf_pipeline_record(pipeline, (gf_trace_record){
+                                     .type = GF_TRACE_HINTS,
+                                     .window = clients->id[index],
+                                     .hints = clients->hints[index],
+                                 });
+  gf_pipeline_record(pipeline, (gf_trace_record){
+                                   .type = GF_TRACE_FRAME,
+                                   .window = clients->id[index],
+                                   .frame = clients->frame[index],
+                               });
+
+  gf_layout_schedule_mark(&pipeline->schedule, previous_desktop);
+  gf_layout_schedule_mark(&pipeline->schedule, clients->desktop[index]);
+}
+
+void gf_pipeline_destroy(gf_pipeline *pipeline, Window window) {
+  long index = gf_client_table_find(&pipeline->clients, window);
+  if (index < 0)
+    return;
+
+  gf_pipeline_record(pipeline, (gf_trace_record){.type = GF_TRACE_DESTROY,
+                                                 .window = window});
+
+  gf_pipeline_forget(pipeline, &pipeline->clients, index);
+  gf_client_table_remove(&pipeline->clients, index);
+}
+
+void gf_pipeline_mark(gf_pipeline *pipeline, long workspace) {
+  gf_pipeline_record(pipeline,
+                     (gf_trace_record){.type = GF_TRACE_MARK,
+                                       .value = workspace});
+  gf_layout_schedule_mark(&pipeline->schedule, workspace);
+}
+
+void gf_pipeline_mark_all(gf_pipeline *pipeline, int workspace_count) {
+  gf_pipeline_record(pipeline,
+                     (gf_trace_record){.type = GF_TRACE_MARK_ALL,
+                                       .value = workspace_count});
+  gf_layout_schedule_mark_all(&pipeline->schedule, workspace_count);
+}
+
+void gf_pipeline_set_outputs(gf_pipeline *pipeline, const gf_rect *areas,
+                             int count) {
+  if (count <= 0)
+    return;
+  if (count > GF_LAYOUT_MAX_OUTPUTS)
+    count = GF_LAYOUT_MAX_OUTPUTS;
+
+  gf_pipeline_record(pipeline, (gf_trace_record){.type = GF_TRACE_OUTPUTS,
+                                                 .rects = (gf_rect *)areas,
+                                                 .count = count});
+
+  unsigned int changed = 0;
+  int span = count > pipeline->output_count ? count : pipeline->output_count;
+  for (int i = 0; i < span; i++) {
+    if (i >= count || i >= pipeline->output_count ||
+        !gf_rect_equal(areas[i], pipeline->outputs[i]))
+      changed |= 1u << i;
+  }
+
+  memcpy(pipeline->outputs, areas, count * sizeof(*areas));
+  pipeline->output_count = count;
+
+  for (int workspace = 0; workspace < pipeline->snapshot.workspace_count;
+       workspace++)
+    gf_layout_schedule_mark_outputs(&pipeline->schedule, workspace, changed);
+}
+
+static int gf_pipeline_output_of(const gf_pipeline *pipeline, gf_rect rect) {
+  int x = rect.x + rect.width / 2;
+  int y = rect.y + rect.height / 2;
+  int nearest = 0;
+  long long nearest_distance = -1;
+
+  for (int i = 0; i < pipeline->output_count; i++) {
+    gf_rect output = pipeline->outputs[i];
+    int dx = x < output.x                  ? output.x - x
+             : x >= output.x + output.width ? x - (output.x + output.width - 1)
+                                            : 0;
+    int dy = y < output.y                   ? output.y - y
+             : y >= output.y + output.height ? y - (output.y + output.height - 1)
+                                             : 0;
+
+    // Centers off every monitor, e.g. after an unplug, go to the closest
+    long long distance = (long long)dx * dx + (long long)dy * dy;
+    if (distance == 0)
+      return i;
+    if (nearest_distance < 0 || distance < nearest_distance) {
+      nearest = i;
+      nearest_distance = distance;
+    }
+  }
+  return nearest;
+}
+
+// Hands one tile to the backend. A client painting in sync is waited for
+// before it gets the next one.
+static void gf_pipeline_send(gf_pipeline *pipeline, long index, Window window,
+                             gf_rect rect) {
+  gf_client_table *clients = &pipeline->clients;
+
+  if (index >= 0) {
+    // Tiles include the decorations, the configure is for the client alone
+    rect = gf_client_table_client_rect(clients, index, rect);
+    clients->flags[index] |= GF_CLIENT_CONFIGURING;
+    if ((clients->flags[index] & GF_CLIENT_SYNC) && pipeline->sync_timeout_ns) {
+      clients->flags[index] |= GF_CLIENT_SYNCING;
+      clients->sync[index].deadline_ns =
+          gf_stats_now_ns() + pipeline->sync_timeout_ns;
+      pipeline->syncing++;
+    }
+  }
+
+  pipeline->backend.configure(pipeline->backend.user_data, window, rect);
+}
+
+static void gf_pipeline_commit(gf_pipeline *pipeline) {
+  gf_client_table *clients = &pipeline->clients;
+  gf_layout_plan *plan = &pipeline->plan;
+  gf_client_table_diff(clients, plan);
+
+  for (unsigned long i = 0; i < plan->count; i++) {
+    long index = gf_client_table_find(clients, plan->windows[i]);
+
+    // Still painting the last one; `applied` keeps only the newest rect
+    if (index >= 0 && (clients->flags[index] & GF_CLIENT_SYNCING)) {
+      clients->flags[index] |= GF_CLIENT_HELD;
+      continue;
+    }
+    gf_pipeline_send(pipeline, index, plan->windows[i], plan->rects[i]);
+  }
+}
+
+void gf_pipeline_synced(gf_pipeline *pipeline, Window window) {
+  gf_client_table *clients = &pipeline->clients;
+  long index = gf_client_table_find(clients, window);
+  if (index < 0 || !(clients->flags[index] & GF_CLIENT_SYNCING))
+    return;
+
+  gf_pipeline_record(pipeline,
+                     (gf_trace_record){.type = GF_TRACE_SYNC, .window = window});
+
+  clients->flags[index] &= ~GF_CLIENT_SYNCING;
+  pipeline->syncing--;
+  if (!(clients->flags[index] & GF_CLIENT_HELD))
+    return;
+
+  // An invalidated rect is already waiting for the next pass
+  clients->flags[index] &= ~GF_CLIENT_HELD;
+  if (clients->applied[index].width >= 0)
+    gf_pipeline_send(pipeline, index, window, clients->applied[index]);
+}
+
+unsigned long long gf_pipeline_sync_deadline(const gf_pipeline *pipeline) {
+  const gf_client_table *clients = &pipeline->clients;
+  unsigned long long deadline = 0;
+
+  for (unsigned long i = 0; pipeline->syncing && i < clients->count; i++) {
+    if ((clients->flags[i] & GF_CLIENT_SYNCING) &&
+        (!deadline || clients->sync[i].deadline_ns < deadline))
+      deadline = clients->sync[i].deadline_ns;
+  }
+  return deadline;
+}
+
+void gf_pipeline_expire_syncs(gf_pipeline *pipeline,
+                              unsigned long long now_ns) {
+  gf_client_table *clients = &pipeline->clients;
+
+  for (unsigned long i = 0; pipeline->syncing && i < clients->count; i++) {
+    if (!(clients->flags[i] & GF_CLIENT_SYNCING) ||
+        clients->sync[i].deadline_ns > now_ns)
+      continue;
+
+    // A busy or hung client still gets its size, just not every step
+    LOG(GF_DBG, "Window 0x%lx did not answer its sync request in time",
+        clients->id[i]);
+    gf_pipeline_synced(pipeline, clients->id[i]);
+  }
+}
+
+// Brings a tree in line with the tiles of its output: leaves of windows that
+// left collapse, new windows split a leaf and every leaf picks up its
+// window's current hints. The tiles are already flagged GF_CLIENT_TILED.
+static int gf_pipeline_sync_tree(gf_pipeline *pipeline, gf_layout_tree *tree,
+                                 const Window *windows, unsigned long count) {
+  gf_client_table *clients = &pipeline->clients;
+  gf_client_leaf *leaf = clients->leaf;
+  int id = gf_pipeline_tree_id(pipeline, tree);
+  int status = 0;
+
+  unsigned long kept = 0;
+  for (unsigned long i = 0; i < count; i++) {
+    long index = gf_client_table_find(clients, windows[i]);
+    if (index >= 0 && leaf[index].tree == id)
+      kept++;
+  }
+
+  // Only a window that left strands a leaf; find those by walking the nodes
+  if (tree->root && kept < tree->nodes[tree->root].leaves) {
+    for (int node = 1; node < tree->capacity; node++) {
+      if (tree->nodes[node].leaves != 1)
+        continue;
+
+      long index = gf_client_table_find(clients, tree->nodes[node].window);
+      int owned = index >= 0 && leaf[index].tree == id &&
+                  leaf[index].node == node;
+      if (owned && (clients->flags[index] & GF_CLIENT_TILED))
+        continue;
+
+      if (owned)
+        leaf[index] = (gf_client_leaf){0, 0};
+      gf_layout_tree_remove(tree, node);
+    }
+  }
+
+  // Whatever has no leaf here yet splits one
+  for (unsigned long i = 0; i < count; i++) {
+    long index = gf_client_table_find(clients, windows[i]);
+    if (index < 0 || !(clients->flags[index] & GF_CLIENT_TILED))
+      continue;
+
+    clients->flags[index] &= ~GF_CLIENT_TILED;
+    if (leaf[index].tree != id) {
+      int node = status < 0 ? 0 : gf_layout_tree_insert(tree, windows[i]);
+      if (!node) {
+        status = -1;
+        continue;
+      }
+      leaf[index] = (gf_client_leaf){id, node};
+    }
+    tree->nodes[leaf[index].node].hints =
+        gf_client_table_outer_hints(clients, index);
+  }
+  return status;
+}
+
+// Lays out and commits just the tiles below `node`, for a change that
+// cannot have moved anything outside it
+static int gf_pipeline_arrange_node(gf_pipeline *pipeline,
+                                    const gf_layout_params *params,
+                                    const gf_layout_tree *tree, int output,
+                                    int node) {
+  gf_layout_plan *plan = &pipeline->plan;
+  unsigned long count = tree->nodes[node].leaves;
+
+  gf_layout_plan_reset(plan);
+  plan->windows = gf_arena_alloc(&pipeline->arena, count * sizeof(Window));
+  plan->rects = gf_arena_alloc(&pipeline->arena, count * sizeof(gf_rect));
+  plan->capacity = plan->windows && plan->rects ? count : 0;
+  if (plan->capacity == 0)
+    return -1;
+
+  gf_stats_scope scope = gf_stats_begin(GF_STAGE_ARRANGE);
+  plan->count = gf_layout_tree_compute_node(
+      params, tree, pipeline->outputs[output], node, plan->windows,
+      plan->rects);
+  gf_stats_end(&scope);
+
+  scope = gf_stats_begin(GF_STAGE_COMMIT);
+  gf_pipeline_commit(pipeline);
+  gf_stats_end(&scope);
+  return 0;
+}
+
+static int gf_pipeline_resize(gf_pipeline *pipeline, unsigned long index,
+                              int dw, int dh, int from_left, int from_top) {
+  gf_client_table *clients = &pipeline->clients;
+  long workspace = clients->desktop[index];
+  int output = clients->output[index];
+  const gf_layout_params *params =
+      gf_layout_table_get(&pipeline->layouts, (int)workspace);
+
+  if (params->kind != GF_LAYOUT_BSP || workspace < 0 || output < 0 ||
+      output >= pipeline->output_count ||
+      (clients->flags[index] & GF_CLIENT_EXCLUDED))
+    return 0;
+
+  gf_layout_tree *tree = gf_pipeline_tree(pipeline, workspace, output, 0);
+  if (!tree || clients->leaf[index].tree != gf_pipeline_tree_id(pipeline, tree))
+    return 0;
+
+  int split = gf_layout_tree_resize(params, tree, pipeline->outputs[output],
+                                    clients->leaf[index].node, dw, dh,
+                                    from_left, from_top);
+  if (!split)
+    return 0;
+
+  // Nothing else touched this output since its last pass, so the tree still
+  // matches its tiles and only the ones under the split have to move
+  if (pipeline->paused ||
+      (gf_layout_schedule_peek(&pipeline->schedule, workspace) &
+       (1u << output)) ||
+      gf_pipeline_arrange_node(pipeline, params, tree, output, split) < 0)
+    gf_layout_schedule_mark_outputs(&pipeline->schedule, workspace,
+                                    1u << output);
+  return 1;
+}
+
+void gf_pipeline_configure(gf_pipeline *pipeline, Window window,
+                           gf_rect geometry) {
+  gf_client_table *clients = &pipeline->clients;
+  long index = gf_client_table_find(clients, window);
+  if (index < 0)
+    return;
+
+  gf_pipeline_record(pipeline, (gf_trace_record){.type = GF_TRACE_CONFIGURE,
+                                                 .window = window,
+                                                 .rect = geometry});
+
+  gf_rect previous = clients->geometry[index];
+  gf_rect expected =
+      gf_client_table_client_rect(clients, index, clients->applied[index]);
+  int answered = clients->flags[index] & GF_CLIENT_CONFIGURING;
+  clients->flags[index] &= ~GF_CLIENT_CONFIGURING;
+  clients->geometry[index] = geometry;
+
+  // Our own commits echo back here; only an unexpected size needs a relayout
+  if ((geometry.width == previous.width &&
+       geometry.height == previous.height) ||
+      (geometry.width == expected.width && geometry.height == expected.height))
+    return;
+
+  // The WM answered our configure with a size of its own; asking again
+  // would only start the same negotiation over, so take what it granted
+  if (answered && clients->applied[index].width >= 0)
+    return;
+
+  // Dragging a tile edge; only synthetic notifies show a moved left or top
+  if (clients->applied[index].width >= 0 &&
+      gf_pipeline_resize(pipeline, index, geometry.width - expected.width,
+                         geometry.height - expected.height,
+                         geometry.x != expected.x, geometry.y != expected.y))
+    return;
+
+  // Resized behind our back, so the last commit no longer holds
+  gf_client_table_invalidate(clients, index);
+  // While paused the pass after the resume unmaximizes it with the rest
+  if (!pipeline->paused)
+    pipeline->backend.unmaximize(pipeline->backend.user_data, window);
+  gf_layout_schedule_mark(&pipeline->schedule, clients->desktop[index]);
+}
+
+static void gf_pipeline_arrange(gf_pipeline *pipeline, int workspace,
+                                int output, Window *windows,
+                                unsigned long count) {
+  gf_client_table *clients = &pipeline->clients;
+  gf_layout_plan *plan = &pipeline->plan;
+
+  gf_layout_plan_reset(plan);
+  if (count == 0)
+    return;
+
+  // The plan lives in the cycle arena; nothing survives past the commit
+  plan->windows = gf_arena_alloc(&pipeline->arena, count * sizeof(Window));
+  plan->rects = gf_arena_alloc(&pipeline->arena, count * sizeof(gf_rect));
+  gf_size_hints *hints =
+      gf_arena_alloc(&pipeline->arena, count * sizeof(gf_size_hints));
+  plan->capacity = plan->windows && plan->rects && hints ? count : 0;
+  if (plan->capacity == 0)
+    return;
+
+  const gf_layout_params *params =
+      gf_layout_table_get(&pipeline->layouts, workspace);
+  gf_layout_tree *tree = params->kind == GF_LAYOUT_BSP
+                             ? gf_pipeline_tree(pipeline, workspace, output, 1)
+                             : NULL;
+
+  gf_stats_scope scope = gf_stats_begin(GF_STAGE_ARRANGE);
+  for (unsigned long i = 0; i < count; i++) {
+    long index = gf_client_table_find(clients, windows[i]);
+    if (index >= 0 && clients->output[index] == output) {
+      if (tree)
+        clients->flags[index] |= GF_CLIENT_TILED;
+      hints[plan->count] = gf_client_table_outer_hints(clients, index);
+      plan->windows[plan->count++] = windows[i];
+    }
+  }
+
+  // BSP keeps its tree between passes, so one window coming or going only
+  // moves the tiles of the split it touched and the diff drops the rest
+  if (tree && gf_pipeline_sync_tree(pipeline, tree, plan->windows,
+                                    plan->count) == 0)
+    plan->count = gf_layout_tree_compute(params, tree,
+                                         pipeline->outputs[output],
+                                         plan->windows, plan->rects);
+  else
+    gf_layout_compute(params, plan->count, pipeline->outputs[output], hints,
+                      plan->rects);
+  gf_stats_end(&scope);
+
+  scope = gf_stats_begin(GF_STAGE_COMMIT);
+  gf_pipeline_commit(pipeline);
+  gf_stats_end(&scope);
+}
+
+static void gf_pipeline_distribute_overflow(gf_pipeline *pipeline,
+                                            int *overflow_workspace,
+                                            int overflow_workspace_total,
+                                            gf_workspace_info *free_workspace,
+                                            int free_workspace_total) {
+  gf_pipeline_backend *backend = &pipeline->backend;
+  unsigned long max_windows = (unsigned long)pipeline->max_windows;
+
+  for (int i = 0; i < overflow_workspace_total; i++) {
+    unsigned long current_window_count = 0;
+    Window *active_windows = gf_workspace_snapshot_windows(
+        &pipeline->snapshot, overflow_workspace[i], &current_window_count);
+
+    for (int j = 0; j < free_workspace_total; j++) {
+      while (current_window_count > max_windows &&
+             free_workspace[j].available_space > 0) {
+        Window window = active_windows[--current_window_count];
+        backend->unmaximize(backend->user_data, window);
+        backend->move(backend->user_data, window,
+                      free_workspace[j].workspace_id);
+        free_workspace[j].available_space--;
+      }
+    }
+
+    // Moved windows leave from the tail; the rest is laid out this batch
+    pipeline->snapshot.count[overflow_workspace[i]] = current_window_count;
+    gf_layout_schedule_mark(&pipeline->schedule, overflow_workspace[i]);
+  }
+}
+
+static void gf_pipeline_handle_overflow(gf_pipeline *pipeline) {
+  int total_workspace = pipeline->snapshot.workspace_count;
+  unsigned long max_windows = (unsigned long)pipeline->max_windows;
+  int *overflow_workspace =
+      gf_arena_alloc(&pipeline->arena, total_workspace * sizeof(int));
+  int overflow_workspace_total = 0;
+
+  gf_workspace_info *free_workspace = gf_arena_alloc(
+      &pipeline->arena, total_workspace * sizeof(gf_workspace_info));
+  int free_workspace_total = 0;
+
+  if (!overflow_workspace || !free_workspace)
+    return;
+
+  for (int workspace = 0; workspace < total_workspace; workspace++) {
+    unsigned long current_window_count = pipeline->snapshot.count[workspace];
+
+    if (current_window_count > max_windows) {
+      overflow_workspace[overflow_workspace_total] = workspace;
+      overflow_workspace_total++;
+    } else if (current_window_count < max_windows) {
+      free_workspace[free_workspace_total].workspace_id = workspace;
+      free_workspace[free_workspace_total].total_window_open =
+          current_window_count;
+      free_workspace[free_workspace_total].available_space =
+          max_windows - current_window_count;
+      free_workspace_total++;
+    }
+  }
+
+  if (overflow_workspace_total == 0)
+    return;
+
+  gf_pipeline_distribute_overflow(pipeline, overflow_workspace,
+                                  overflow_workspace_total, free_workspace,
+                                  free_workspace_total);
+}
+
+static void gf_pipeline_layout_workspace(gf_pipeline *pipeline, int workspace,
+                                         unsigned int outputs) {
+  gf_client_table *clients = &pipeline->clients;
+  unsigned long window_count = 0;
+  Window *windows = gf_workspace_snapshot_windows(&pipeline->snapshot,
+                                                  workspace, &window_count);
+
+  // A window belongs to the monitor holding its center; one that changed
+  // monitor dirties both the one it left and the one it joined
+  for (unsigned long i = 0; i < window_count; i++) {
+    long index = gf_client_table_find(clients, windows[i]);
+    if (index < 0)
+      continue;
+
+    gf_rect rect = clients->applied[index].width < 0 ? clients->geometry[index]
+                                                     : clients->applied[index];
+    int output = gf_pipeline_output_of(pipeline, rect);
+    if (clients->output[index] != output) {
+      if (clients->output[index] >= 0)
+        outputs |= 1u << clients->output[index];
+      outputs |= 1u << output;
+      clients->output[index] = output;
+    }
+  }
+
+  // Only windows without a standing commit can still be maximized
+  for (unsigned long i = 0; i < window_count; i++) {
+    long index = gf_client_table_find(clients, windows[i]);
+    if (index >= 0 && clients->applied[index].width < 0 &&
+        (outputs & (1u << clients->output[index])))
+      pipeline->backend.unmaximize(pipeline->backend.user_data, windows[i]);
+  }
+
+  for (int output = 0; output < pipeline->output_count; output++) {
+    if (outputs & (1u << output))
+      gf_pipeline_arrange(pipeline, workspace, output, windows, window_count);
+  }
+}
+
+void gf_pipeline_run(gf_pipeline *pipeline, int workspace_count) {
+  gf_pipeline_record(pipeline,
+                     (gf_trace_record){.type = GF_TRACE_PASS,
+                                       .value = workspace_count});
+
+  // Whatever is dirty stays so until a resume
+  if (pipeline->paused)
+    return;
+
+  gf_stats_scope pass = gf_stats_begin(GF_STAGE_PASS);
+
+  // Every stage below reads this one snapshot instead of refetching
+  gf_stats_scope scope = gf_stats_begin(GF_STAGE_FILTER);
+  int built = gf_workspace_snapshot_build(&pipeline->snapshot,
+                                          &pipeline->clients, workspace_count);
+  gf_stats_end(&scope);
+
+  if (built == 0) {
+    // Without a limit every window stays where the user put it
+    if (pipeline->max_windows != GF_PIPELINE_UNLIMITED) {
+      scope = gf_stats_begin(GF_STAGE_OVERFLOW);
+      unsigned long workspace_need =
+          pipeline->snapshot.total / (unsigned long)pipeline->max_windows;
+      if ((unsigned long)workspace_count <= workspace_need)
+        gf_workspace_provision(&pipeline->provisioner, workspace_count,
+                               workspace_need + 1);
+
+      gf_pipeline_handle_overflow(pipeline);
+      gf_stats_end(&scope);
+    }
+
+    for (int workspace = 0; workspace < pipeline->snapshot.workspace_count;
+         workspace++) {
+      unsigned int outputs =
+          gf_layout_schedule_take(&pipeline->schedule, workspace);
+      if (outputs)
+        gf_pipeline_layout_workspace(pipeline, workspace, outputs);
+    }
+    gf_layout_schedule_clear(&pipeline->schedule);
+  }
+
+  gf_stats_end(&pass);
+}
+
+void gf_pipeline_relayout(gf_pipeline *pipeline, long workspace) {
+  gf_client_table *clients = &pipeline->clients;
+
+  gf_pipeline_record(pipeline, (gf_trace_record){.type = GF_TRACE_RELAYOUT,
+                                                 .value = workspace});
+
+  // Fresh trees drop the splits the user dragged
+  for (long ws = 0; ws < pipeline->tree_workspaces; ws++) {
+    if (workspace >= 0 && ws != workspace)
+      continue;
+    for (int output = 0; output < GF_LAYOUT_MAX_OUTPUTS; output++)
+      gf_layout_tree_free(&pipeline->trees[ws * GF_LAYOUT_MAX_OUTPUTS + output]);
+  }
+
+  for (unsigned long i = 0; i < clients->count; i++) {
+    int tree = clients->leaf[i].tree;
+    if (tree && (workspace < 0 ||
+                 (tree - 1) / GF_LAYOUT_MAX_OUTPUTS == workspace))
+      clients->leaf[i] = (gf_client_leaf){0, 0};
+
+    if (workspace >= 0 && clients->desktop[i] != workspace)
+      continue;
+    gf_client_table_invalidate(clients, i);
+    gf_layout_schedule_mark(&pipeline->schedule, clients->desktop[i]);
+  }
+}
+
+int gf_pipeline_set_layout(gf_pipeline *pipeline, long workspace,
+                           gf_layout_kind kind) {
+  if (workspace < 0 || kind >= GF_LAYOUT_KIND_COUNT)
+    return -1;
+
+  gf_layout_params params = *gf_layout_table_get(&pipeline->layouts, workspace);
+  params.kind = kind;
+  if (gf_layout_table_set(&pipeline->layouts, workspace, params) < 0)
+    return -1;
+
+  gf_pipeline_record(pipeline, (gf_trace_record){.type = GF_TRACE_LAYOUT,
+                                                 .value = workspace,
+                                                 .flags = kind});
+  gf_layout_schedule_mark(&pipeline->schedule, workspace);
+  return 0;
+}
+
+void gf_pipeline_set_capacity(gf_pipeline *pipeline, int max_windows) {
+  gf_client_table *clients = &pipeline->clients;
+
+  gf_pipeline_record(pipeline, (gf_trace_record){.type = GF_TRACE_CAPACITY,
+                                                 .value = max_windows});
+
+  // Overflow is judged per pass, so any occupied workspace may be affected
+  pipeline->max_windows = max_windows;
+  for (unsigned long i = 0; i < clients->count; i++)
+    gf_layout_schedule_mark(&pipeline->schedule, clients->desktop[i]);
+}
+
+void gf_pipeline_pause(gf_pipeline *pipeline, int paused) {
+  gf_pipeline_record(pipeline, (gf_trace_record){.type = GF_TRACE_PAUSE,
+                                                 .value = paused});
+  pipeline->paused = paused;
+}
+
+static void gf_pipeline_apply_client(gf_pipeline *pipeline,
+                                     const gf_trace_record *record) {
+  gf_client_table *clients = &pipeline->clients;
+  long index = gf_client_table_find(clients, record->window);
+  if (index < 0)
+    return;
+
+  long previous_desktop = clients->desktop[index];
+  clients->flags[index] = (record->flags & GF_CLIENT_FETCHED) |
+                          (clients->flags[index] & ~GF_CLIENT_FETCHED);
+  gf_client_table_set_desktop(clients, index, record->value);
+  clients->geometry[index] = record->rect;
+  clients->hints[index] = record->hints;
+  gf_client_table_set_frame(clients, index, record->frame);
+  gf_pipeline_client_changed(pipeline, index, previous_desktop);
+}
+
+void gf_pipeline_apply(gf_pipeline *pipeline, const gf_trace_record *record) {
+  long index;
+
+  switch (record->type) {
+  case GF_TRACE_CLIENT_LIST:
+    gf_pipeline_sync_clients(pipeline, record->windows, record->count);
+    break;
+  case GF_TRACE_CLIENT:
+    gf_pipeline_apply_client(pipeline, record);
+    break;
+  case GF_TRACE_CONFIGURE:
+    gf_pipeline_configure(pipeline, record->window, record->rect);
+    break;
+  case GF_TRACE_DESTROY:
+    gf_pipeline_destroy(pipeline, record->window);
+    break;
+  case GF_TRACE_MARK:
+    gf_pipeline_mark(pipeline, record->value);
+    break;
+  case GF_TRACE_MARK_ALL:
+    gf_pipeline_mark_all(pipeline, (int)record->value);
+    break;
+  case GF_TRACE_PASS:
+    gf_pipeline_run(pipeline, (int)record->value);
+    break;
+  case GF_TRACE_OUTPUTS:
+    gf_pipeline_set_outputs(pipeline, record->rects, (int)record->count);
+    break;
+  case GF_TRACE_HINTS:
+    index = gf_client_table_find(&pipeline->clients, record->window);
+    if (index >= 0)
+      pipeline->clients.hints[index] = record->hints;
+    break;
+  case GF_TRACE_FRAME:
+    index = gf_client_table_find(&pipeline->clients, record->window);
+    if (index >= 0)
+      gf_client_table_set_frame(&pipeline->clients, index, record->frame);
+    break;
+  case GF_TRACE_SYNC:
+    gf_pipeline_synced(pipeline, record->window);
+    break;
+  case GF_TRACE_RELAYOUT:
+    gf_pipeline_relayout(pipeline, record->value);
+    break;
+  case GF_TRACE_LAYOUT:
+    gf_pipeline_set_layout(pipeline, record->value,
+                           (gf_layout_kind)record->flags);
+    break;
+  case GF_TRACE_CAPACITY:
+    gf_pipeline_set_capacity(pipeline, (int)record->value);
+    break;
+  case GF_TRACE_PAUSE:
+    gf_pipeline_pause(pipeline, record->value != 0);
+    break;
+  }
+}
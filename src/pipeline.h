@@ -0,0 +1,143 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_PIPELINE
+#define GF_PIPELINE
+
+#include "arena.h"
+#include "client.h"
+#include "layout.h"
+#include "trace.h"
+#include "workspace.h"
+#include <X11/X.h>
+#include <stdio.h>
+
+#define GF_PIPELINE_MAX_WINDOWS 8 // default tiles per workspace
+#define GF_PIPELINE_UNLIMITED 0
+#define GF_PIPELINE_SYNC_TIMEOUT_MS 100 // default wait for a client repaint
+
+typedef struct {
+  int workspace_id;
+  int total_window_open;
+  int available_space;
+} gf_workspace_info;
+
+// Side effects of a layout pass. The planner hands them to the X thread,
+// a replay only reports them. A configure for a client flagged
+// GF_CLIENT_SYNCING has to be preceded by a sync request.
+typedef struct {
+  void (*unmaximize)(void *user_data, Window window);
+  void (*move)(void *user_data, Window window, long workspace);
+  void (*configure)(void *user_data, Window window, gf_rect rect);
+  void *user_data;
+} gf_pipeline_backend;
+
+// The decision half of the window manager: the client table and everything
+// derived from it. Inputs enter through the calls below, which also append
+// them to `trace` when recording, so a replay walks the same code.
+typedef struct {
+  gf_client_table clients;
+  gf_workspace_snapshot snapshot;
+  gf_layout_plan plan;
+  gf_layout_schedule schedule;
+  gf_layout_table layouts;
+  gf_workspace_provisioner provisioner;
+  gf_pipeline_backend backend;
+
+  gf_rect outputs[GF_LAYOUT_MAX_OUTPUTS];
+  int output_count;
+
+  // Persistent BSP of each workspace and output
+  gf_layout_tree *trees;
+  int tree_workspaces;
+
+  int max_windows; // beyond it windows move on, GF_PIPELINE_UNLIMITED keeps all
+
+  // A client that speaks _NET_WM_SYNC_REQUEST gets no new configure until
+  // it painted the last one or this long passed; 0 sends them unpaced
+  unsigned long long sync_timeout_ns;
+  unsigned long syncing; // clients we are waiting for
+  int paused;            // passes leave the dirty workspaces for later
+  gf_trace *trace;
+
+  // Scratch for one processing cycle, reset by whoever drives the cycle
+  gf_arena arena;
+} gf_pipeline;
+
+int gf_pipeline_init(gf_pipeline *pipeline, gf_pipeline_backend backend,
+                     gf_workspace_backend workspaces, gf_rect area,
+                     const char *layouts);
+void gf_pipeline_free(gf_pipeline *pipeline);
+
+// Reads a window limit such as GRIDFLUX_MAX_WINDOWS: a count, or 0 or
+// "unlimited" for no limit. Unset or invalid values give the default.
+int gf_pipeline_parse_max_windows(const char *value);
+// Reads a sync timeout such as GRIDFLUX_SYNC_TIMEOUT_MS into nanoseconds;
+// 0 turns pacing off. Unset or invalid values give the default.
+unsigned long long gf_pipeline_parse_sync_timeout(const char *value);
+
+// Drops clients missing from `windows` and appends the new ones; returns the
+// index of the first new client, whose state the caller fills in and then
+// reports through gf_pipeline_client_changed.
+unsigned long gf_pipeline_sync_clients(gf_pipeline *pipeline,
+                                       const Window *windows,
+                                       unsigned long count);
+void gf_pipeline_client_changed(gf_pipeline *pipeline, unsigned long index,
+                                long previous_desktop);
+// A size we did not ask for is a user resize: under BSP it moves the split
+// owning the dragged edge, otherwise the window is tiled back.
+void gf_pipeline_configure(gf_pipeline *pipeline, Window window,
+                           gf_rect geometry);
+void gf_pipeline_destroy(gf_pipeline *pipeline, Window window);
+
+// The client painted our last configure, or we stopped waiting for it:
+// the newest rect held back meanwhile goes out now.
+void gf_pipeline_synced(gf_pipeline *pipeline, Window window);
+// Earliest moment a client stops being waited for, 0 when none is.
+unsigned long long gf_pipeline_sync_deadline(const gf_pipeline *pipeline);
+void gf_pipeline_expire_syncs(gf_pipeline *pipeline,
+                              unsigned long long now_ns);
+void gf_pipeline_mark(gf_pipeline *pipeline, long workspace);
+void gf_pipeline_mark_all(gf_pipeline *pipeline, int workspace_count);
+
+// Replaces the usable area of each monitor. Only outputs whose area changed,
+// and those their windows move to, are laid out again.
+void gf_pipeline_set_outputs(gf_pipeline *pipeline, const gf_rect *areas,
+                             int count);
+
+// Lays out every dirty workspace once, moving overflow windows first.
+void gf_pipeline_run(gf_pipeline *pipeline, int workspace_count);
+
+// Commands from outside the X inputs, recorded like them. A relayout
+// resends every tile of `workspace` (-1 for all) even if it did not move.
+void gf_pipeline_relayout(gf_pipeline *pipeline, long workspace);
+int gf_pipeline_set_layout(gf_pipeline *pipeline, long workspace,
+                           gf_layout_kind kind);
+void gf_pipeline_set_capacity(gf_pipeline *pipeline, int max_windows);
+void gf_pipeline_pause(gf_pipeline *pipeline, int paused);
+
+// Feeds one input to the matching call above. A CLIENT record carries the
+// whole fetched state of the window, hints and frame included.
+void gf_pipeline_apply(gf_pipeline *pipeline, const gf_trace_record *record);
+
+// Feeds a recorded trace through the pipeline with a backend that prints
+// each decision and the cost of every step to `out`.
+int gf_pipeline_replay(const char *path, FILE *out);
+
+#endif // GF_PIPELINE
@@ -0,0 +1,398 @@
+#include "planner.h"
+#include "ewmh.h"
+#include "gridflux.h"
+#include "stats.h"
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GF_PLANNER_RETRY_MS 1 // while a queue is full
+// Set in the flags of a posted record whose lists live in a ring slot; no
+// record carrying a list uses its flags otherwise
+#define GF_PLANNER_LISTS_SLOT 0x80000000u
+
+static void gf_planner_push(gf_planner *planner, gf_action action) {
+  gf_spsc_push(&planner->actions, &action);
+}
+
+static void gf_planner_unmaximize(void *user_data, Window window) {
+  gf_planner_push(user_data, (gf_action){.type = GF_ACTION_UNMAXIMIZE,
+                                         .window = window});
+}
+
+static void gf_planner_move(void *user_data, Window window, long workspace) {
+  gf_planner_push(user_data, (gf_action){.type = GF_ACTION_MOVE,
+                                         .window = window,
+                                         .value = workspace});
+}
+
+static void gf_planner_configure(void *user_data, Window window,
+                                 gf_rect rect) {
+  gf_planner *planner = user_data;
+  gf_client_table *clients = &planner->pipeline.clients;
+  long index = gf_client_table_find(clients, window);
+
+  // The X thread keeps the sync counter, so it has to be told to use it
+  unsigned int flags = index >= 0 ? clients->flags[index] & GF_CLIENT_SYNCING
+                                  : 0;
+  gf_planner_push(planner, (gf_action){.type = GF_ACTION_CONFIGURE,
+                                       .window = window,
+                                       .flags = flags,
+                                       .rect = rect});
+}
+
+// The request goes out from the X thread; like any backend it only has to
+// be sent, the new count arrives through the usual events.
+static int gf_planner_request_workspace(void *user_data, unsigned long current,
+                                        unsigned long wanted) {
+  gf_planner_push(user_data, (gf_action){.type = GF_ACTION_WORKSPACES,
+                                         .value = (long)wanted,
+                                         .current = current});
+  return 0;
+}
+
+int gf_planner_init(gf_planner *planner, const char *workspace_backend,
+                    gf_rect area, const char *layouts) {
+  memset(planner, 0, sizeof(*planner));
+
+  gf_pipeline_backend backend = {.unmaximize = gf_planner_unmaximize,
+                                 .move = gf_planner_move,
+                                 .configure = gf_planner_configure,
+                                 .user_data = planner};
+  gf_workspace_backend workspaces = {.name = workspace_backend,
+                                     .request = gf_planner_request_workspace,
+                                     .user_data = planner};
+
+  if (gf_spsc_init(&planner->inputs, sizeof(gf_trace_record),
+                   GF_PLANNER_QUEUE_SIZE) < 0)
+    return -1;
+  if (gf_spsc_init(&planner->actions, sizeof(gf_action),
+                   GF_PLANNER_QUEUE_SIZE) < 0) {
+    gf_spsc_free(&planner->inputs);
+    return -1;
+  }
+  if (gf_pipeline_init(&planner->pipeline, backend, workspaces, area,
+                       layouts) < 0) {
+    gf_spsc_free(&planner->inputs);
+    gf_spsc_free(&planner->actions);
+    return -1;
+  }
+  return 0;
+}
+
+// Hands the lists of an applied record back: its ring slot to the X
+// thread, or the heap when the ring was full as it was posted.
+static void gf_planner_release(gf_planner *planner, gf_trace_record *record) {
+  if (record->flags & GF_PLANNER_LISTS_SLOT) {
+    __atomic_store_n(&planner->lists_released, planner->lists_released + 1,
+                     __ATOMIC_RELEASE);
+    return;
+  }
+  free(record->windows);
+  free(record->rects);
+}
+
+static void gf_planner_query(gf_planner *planner, Window requester,
+                             long workspace) {
+  const gf_pipeline *pipeline = &planner->pipeline;
+  const gf_client_table *clients = &pipeline->clients;
+  gf_control_reply reply = {
+      .status = GF_CONTROL_OK,
+      .paused = (uint8_t)pipeline->paused,
+      .layout = (uint8_t)gf_layout_table_get(&pipeline->layouts,
+                                             (int)workspace)->kind,
+      .workspace = (int32_t)workspace,
+      .capacity = (uint32_t)pipeline->max_windows,
+      .workspaces = (uint32_t)planner->workspace_count,
+      .windows = (uint32_t)clients->count,
+  };
+
+  for (unsigned long i = 0; workspace >= 0 && i < clients->count; i++) {
+    if (clients->desktop[i] == workspace)
+      reply.workspace_windows++;
+  }
+  gf_planner_push(planner, (gf_action){.type = GF_ACTION_REPLY,
+                                       .window = requester,
+                                       .reply = reply});
+}
+
+static void gf_planner_step(gf_planner *planner, gf_trace_record *record) {
+  gf_pipeline *pipeline = &planner->pipeline;
+
+  if (record->type == GF_PLANNER_QUERY) {
+    gf_planner_query(planner, record->window, record->value);
+    return;
+  }
+  if (record->type != GF_TRACE_PASS) {
+    gf_pipeline_apply(pipeline, record);
+    return;
+  }
+
+  // Every event batch ends in a PASS, most of them leave nothing to do
+  planner->workspace_count = (int)record->value;
+  if (!pipeline->schedule.pending || pipeline->paused)
+    return;
+  gf_pipeline_run(pipeline, (int)record->value);
+  gf_planner_push(planner, (gf_action){.type = GF_ACTION_DONE});
+}
+
+static void gf_planner_export(gf_planner *planner) {
+  const gf_pipeline *pipeline = &planner->pipeline;
+  const gf_client_table *clients = &pipeline->clients;
+  gf_state *state = gf_state_begin(&planner->state);
+  if (!state)
+    return;
+
+  int workspace_count = planner->workspace_count;
+  state->truncated = workspace_count > GF_STATE_MAX_WORKSPACES;
+  if (state->truncated)
+    workspace_count = GF_STATE_MAX_WORKSPACES;
+
+  state->paused = (uint32_t)pipeline->paused;
+  state->capacity = (uint32_t)pipeline->max_windows;
+  state->windows = (uint32_t)clients->count;
+  state->workspace_count = (uint32_t)workspace_count;
+
+  for (int ws = 0; ws < workspace_count; ws++)
+    state->workspaces[ws] = (gf_state_workspace){
+        .layout = gf_layout_table_get(&pipeline->layouts, ws)->kind};
+
+  // Count first, then place each tile in its workspace's run
+  for (unsigned long i = 0; i < clients->count; i++) {
+    long ws = clients->desktop[i];
+    if (ws < 0 || ws >= workspace_count ||
+        (clients->flags[i] & GF_CLIENT_EXCLUDED))
+      continue;
+    state->workspaces[ws].windows++;
+    if (clients->applied[i].width >= 0)
+      state->workspaces[ws].tiles++;
+  }
+
+  uint32_t offset = 0;
+  uint32_t room[GF_STATE_MAX_WORKSPACES];
+  for (int ws = 0; ws < workspace_count; ws++) {
+    gf_state_workspace *workspace = &state->workspaces[ws];
+    room[ws] = workspace->tiles;
+    if (offset + room[ws] > GF_STATE_MAX_TILES) {
+      room[ws] = GF_STATE_MAX_TILES - offset;
+      state->truncated = 1;
+    }
+    workspace->first_tile = offset;
+    workspace->tiles = 0;
+    offset += room[ws];
+  }
+  state->tile_count = offset;
+
+  for (unsigned long i = 0; i < clients->count; i++) {
+    long ws = clients->desktop[i];
+    if (ws < 0 || ws >= workspace_count ||
+        (clients->flags[i] & GF_CLIENT_EXCLUDED) ||
+        clients->applied[i].width < 0)
+      continue;
+
+    gf_state_workspace *workspace = &state->workspaces[ws];
+    if (workspace->tiles == room[ws])
+      continue;
+
+    uint32_t slot = workspace->first_tile + workspace->tiles;
+    gf_rect rect = clients->applied[i];
+    state->tiles[slot] = (gf_state_tile){.window = clients->id[i],
+                                         .workspace = (int32_t)ws,
+                                         .output = clients->output[i],
+                                         .x = rect.x,
+                                         .y = rect.y,
+                                         .width = rect.width,
+                                         .height = rect.height};
+    workspace->tiles++;
+  }
+
+  gf_state_end(&planner->state);
+}
+
+static int gf_planner_timeout(const gf_planner *planner) {
+  if (planner->actions.backlog_count)
+    return GF_PLANNER_RETRY_MS;
+
+  // Wake up for the first client that runs out of time to answer a sync
+  unsigned long long deadline = gf_pipeline_sync_deadline(&planner->pipeline);
+  if (!deadline)
+    return -1;
+
+  unsigned long long now = gf_stats_now_ns();
+  return deadline > now ? (int)((deadline - now + 999999) / 1000000) : 0;
+}
+
+static void *gf_planner_main(void *arg) {
+  gf_planner *planner = arg;
+  gf_pipeline *pipeline = &planner->pipeline;
+  struct pollfd pfd = {.fd = gf_spsc_fd(&planner->inputs), .events = POLLIN};
+  gf_trace_record record;
+
+  while (!__atomic_load_n(&planner->stopping, __ATOMIC_ACQUIRE)) {
+    if (poll(&pfd, 1, gf_planner_timeout(planner)) < 0 && errno != EINTR) {
+      LOG(GF_ERR, "poll on planner queue failed: %s", strerror(errno));
+      break;
+    }
+    gf_spsc_clear(&planner->inputs);
+
+    // A cycle is whatever the X thread posted since the last one
+    gf_arena_reset(&pipeline->arena);
+    int changed = 0;
+    while (gf_spsc_pop(&planner->inputs, &record)) {
+      changed |= record.type != GF_PLANNER_QUERY;
+      gf_planner_step(planner, &record);
+      gf_planner_release(planner, &record);
+    }
+    gf_pipeline_expire_syncs(pipeline, gf_stats_now_ns());
+    gf_spsc_publish(&planner->actions);
+
+    // Readers see the model once the requests behind it are on their way
+    if (changed)
+      gf_planner_export(planner);
+  }
+  return NULL;
+}
+
+int gf_planner_start(gf_planner *planner) {
+  // Signals stay with the X thread, whose poll they have to interrupt
+  sigset_t all, previous;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &previous);
+  int error = pthread_create(&planner->thread, NULL, gf_planner_main, planner);
+  pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+  if (error) {
+    LOG(GF_ERR, "Cannot start planner thread: %s", strerror(error));
+    return -1;
+  }
+  planner->started = 1;
+  return 0;
+}
+
+void gf_planner_stop(gf_planner *planner) {
+  if (!planner->started)
+    return;
+
+  __atomic_store_n(&planner->stopping, 1, __ATOMIC_RELEASE);
+  gf_spsc_wake(&planner->inputs);
+  pthread_join(planner->thread, NULL);
+  planner->started = 0;
+}
+
+void gf_planner_free(gf_planner *planner) {
+  gf_trace_record record;
+
+  gf_planner_stop(planner);
+  while (gf_spsc_pop(&planner->inputs, &record))
+    gf_planner_release(planner, &record);
+  for (unsigned long i = 0; i < planner->inputs.backlog_count; i++)
+    gf_planner_release(planner,
+                       (gf_trace_record *)(planner->inputs.backlog +
+                                           i * sizeof(gf_trace_record)));
+  for (int i = 0; i < GF_PLANNER_LIST_SLOTS; i++) {
+    free(planner->lists[i].windows);
+    free(planner->lists[i].rects);
+  }
+
+  gf_spsc_free(&planner->inputs);
+  gf_spsc_free(&planner->actions);
+  gf_state_export_close(&planner->state);
+  gf_pipeline_free(&planner->pipeline);
+}
+
+// Grows `buffer` to hold `count` items of `size`; NULL when it cannot.
+static void *gf_planner_grow(void *buffer, unsigned long *capacity,
+                             unsigned long count, size_t size) {
+  if (*capacity >= count)
+    return buffer;
+
+  unsigned long grown_capacity = *capacity ? *capacity * 2 : 64;
+  while (grown_capacity < count)
+    grown_capacity *= 2;
+  void *grown = realloc(buffer, grown_capacity * size);
+  if (!grown) {
+    LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+    return NULL;
+  }
+  *capacity = grown_capacity;
+  return grown;
+}
+
+// Copies the lists of `record` into `copy`: into the next ring slot, or
+// onto the heap while the planner is a whole ring behind.
+static int gf_planner_copy_lists(gf_planner *planner,
+                                 const gf_trace_record *record,
+                                 gf_trace_record *copy) {
+  unsigned long count = record->count;
+  Window *windows = NULL;
+  gf_rect *rects = NULL;
+
+  if (planner->lists_posted -
+          __atomic_load_n(&planner->lists_released, __ATOMIC_ACQUIRE) <
+      GF_PLANNER_LIST_SLOTS) {
+    gf_planner_lists *lists =
+        &planner->lists[planner->lists_posted % GF_PLANNER_LIST_SLOTS];
+    if (record->windows) {
+      windows = gf_planner_grow(lists->windows, &lists->window_capacity,
+                                count, sizeof(Window));
+      if (!windows)
+        return -1;
+      lists->windows = windows;
+    }
+    if (record->rects) {
+      rects = gf_planner_grow(lists->rects, &lists->rect_capacity, count,
+                              sizeof(gf_rect));
+      if (!rects)
+        return -1;
+      lists->rects = rects;
+    }
+    copy->flags |= GF_PLANNER_LISTS_SLOT;
+  } else {
+    if (record->windows && !(windows = malloc(count * sizeof(Window)))) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return -1;
+    }
+    if (record->rects && !(rects = malloc(count * sizeof(gf_rect)))) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      free(windows);
+      return -1;
+    }
+  }
+
+  if (windows)
+    memcpy(windows, record->windows, count * sizeof(Window));
+  if (rects)
+    memcpy(rects, record->rects, count * sizeof(gf_rect));
+  copy->windows = windows;
+  copy->rects = rects;
+  return 0;
+}
+
+// Lists are copied so the X thread can reset its arena right away; the
+// planner hands their storage back once it has applied them.
+void gf_planner_post(gf_planner *planner, const gf_trace_record *record) {
+  gf_trace_record copy = *record;
+
+  copy.windows = NULL;
+  copy.rects = NULL;
+  if ((record->windows || record->rects) && record->count &&
+      gf_planner_copy_lists(planner, record, &copy) < 0)
+    return;
+
+  if (gf_spsc_push(&planner->inputs, &copy) < 0) {
+    if (!(copy.flags & GF_PLANNER_LISTS_SLOT)) {
+      free(copy.windows);
+      free(copy.rects);
+    }
+    return;
+  }
+  // The slot is taken only once the record holding it is on its way
+  if (copy.flags & GF_PLANNER_LISTS_SLOT)
+    planner->lists_posted++;
+}
+
+unsigned long gf_planner_flush(gf_planner *planner) {
+  return gf_spsc_publish(&planner->inputs);
+}
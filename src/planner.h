@@ -0,0 +1,101 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_PLANNER
+#define GF_PLANNER
+
+#include "control.h"
+#include "pipeline.h"
+#include "spsc.h"
+#include "state.h"
+#include <pthread.h>
+
+#define GF_PLANNER_QUEUE_SIZE 4096 // inputs or actions in flight
+#define GF_PLANNER_LIST_SLOTS 16   // posted lists in flight without malloc
+
+// Not an input and never recorded: asks for a GF_ACTION_REPLY describing
+// workspace `value`, addressed to control requester `window`.
+#define GF_PLANNER_QUERY ((gf_trace_type)0)
+
+typedef enum {
+  GF_ACTION_UNMAXIMIZE,
+  GF_ACTION_MOVE,       // value: target workspace
+  GF_ACTION_CONFIGURE,  // rect: client rect, flags: GF_CLIENT_SYNCING if paced
+  GF_ACTION_WORKSPACES, // value: wanted count, current: count it saw
+  GF_ACTION_DONE,       // a layout pass finished
+  GF_ACTION_REPLY,      // window: control requester, reply: its answer
+} gf_action_type;
+
+// One side effect of the pipeline, carried back to the X thread.
+typedef struct {
+  gf_action_type type;
+  Window window;
+  long value;
+  unsigned long current;
+  unsigned int flags;
+  gf_rect rect;
+  gf_control_reply reply;
+} gf_action;
+
+// Where a posted record's window or output list is copied. The buffers only
+// grow, so once they fit the usual lists posting allocates nothing.
+typedef struct {
+  Window *windows;
+  unsigned long window_capacity;
+  gf_rect *rects;
+  unsigned long rect_capacity;
+} gf_planner_lists;
+
+// The pipeline on a thread of its own. The X thread posts each input as
+// the trace record a replay would read, then a PASS once its event batch
+// is drained; the planner applies them, lays out and sends the resulting
+// requests back as actions. Neither side waits on the other: both queues
+// are lock-free, and the X thread keeps reading events while a pass runs.
+typedef struct {
+  gf_pipeline pipeline; // owned by the planner thread once started
+  gf_spsc inputs;       // gf_trace_record, X thread to planner
+  gf_spsc actions;      // gf_action, planner to X thread
+  gf_state_export state; // rewritten after each cycle that had inputs
+  // List storage taken in posting order and handed back in the same order
+  // once applied; each count is advanced by one side only
+  gf_planner_lists lists[GF_PLANNER_LIST_SLOTS];
+  unsigned long lists_posted;   // X thread
+  unsigned long lists_released; // planner
+  int workspace_count; // as of the last PASS
+  pthread_t thread;
+  int started;
+  int stopping;
+} gf_planner;
+
+// Sets up the pipeline; configure planner->pipeline, and open
+// planner->state to export it, before starting.
+int gf_planner_init(gf_planner *planner, const char *workspace_backend,
+                    gf_rect area, const char *layouts);
+int gf_planner_start(gf_planner *planner);
+// Joins the thread; the pipeline is the caller's again afterwards.
+void gf_planner_stop(gf_planner *planner);
+void gf_planner_free(gf_planner *planner);
+
+// X thread: queues a copy of `record`, its window or output list included.
+void gf_planner_post(gf_planner *planner, const gf_trace_record *record);
+// X thread: hands everything posted so far to the planner; returns how many
+// inputs still wait for room in the queue.
+unsigned long gf_planner_flush(gf_planner *planner);
+
+#endif // GF_PLANNER
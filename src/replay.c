@@ -0,0 +1,131 @@
+#include "gridflux.h"
+#include "pipeline.h"
+#include "stats.h"
+#include <string.h>
+
+typedef struct {
+  FILE *out;
+  unsigned long configures;
+  unsigned long moves;
+  unsigned long unmaximizes;
+  unsigned long workspace_requests;
+} gf_replay;
+
+static void gf_replay_unmaximize(void *user_data, Window window) {
+  gf_replay *replay = user_data;
+  replay->unmaximizes++;
+  fprintf(replay->out, "  unmaximize window=0x%lx\n", window);
+}
+
+static void gf_replay_move(void *user_data, Window window, long workspace) {
+  gf_replay *replay = user_data;
+  replay->moves++;
+  fprintf(replay->out, "  move window=0x%lx workspace=%ld\n", window,
+          workspace);
+}
+
+static void gf_replay_configure(void *user_data, Window window, gf_rect rect) {
+  gf_replay *replay = user_data;
+  replay->configures++;
+  fprintf(replay->out, "  configure window=0x%lx x=%d y=%d width=%d height=%d\n",
+          window, rect.x, rect.y, rect.width, rect.height);
+}
+
+static int gf_replay_request_workspace(void *user_data, unsigned long current,
+                                       unsigned long wanted) {
+  gf_replay *replay = user_data;
+  replay->workspace_requests++;
+  fprintf(replay->out, "  workspaces current=%lu wanted=%lu\n", current,
+          wanted);
+  return 0;
+}
+
+// A recorded CLIENT is followed by its HINTS, when it had any, and FRAME
+// records, so it only clears the hints; the rest goes through the same
+// path as the live session.
+static void gf_replay_client(gf_pipeline *pipeline,
+                             const gf_trace_record *record) {
+  gf_client_table *clients = &pipeline->clients;
+  long index = gf_client_table_find(clients, record->window);
+  if (index < 0)
+    return;
+
+  long previous_desktop = clients->desktop[index];
+  clients->flags[index] = (record->flags & GF_CLIENT_FETCHED) |
+                          (clients->flags[index] & ~GF_CLIENT_FETCHED);
+  gf_client_table_set_desktop(clients, index, record->value);
+  clients->geometry[index] = record->rect;
+  memset(&clients->hints[index], 0, sizeof(clients->hints[index]));
+  gf_pipeline_client_changed(pipeline, index, previous_desktop);
+}
+
+static void gf_replay_step(gf_pipeline *pipeline,
+                           const gf_trace_record *record) {
+  if (record->type == GF_TRACE_CLIENT)
+    gf_replay_client(pipeline, record);
+  else
+    gf_pipeline_apply(pipeline, record);
+}
+
+int gf_pipeline_replay(const char *path, FILE *out) {
+  gf_trace trace;
+  gf_trace_header header;
+  if (gf_trace_open_read(&trace, path, &header) < 0)
+    return -1;
+
+  gf_replay replay = {.out = out};
+  gf_pipeline_backend backend = {.unmaximize = gf_replay_unmaximize,
+                                 .move = gf_replay_move,
+                                 .configure = gf_replay_configure,
+                                 .user_data = &replay};
+  gf_workspace_backend workspaces = {.name = "replay",
+                                     .request = gf_replay_request_workspace,
+                                     .user_data = &replay};
+
+  gf_pipeline pipeline;
+  if (gf_pipeline_init(&pipeline, backend, workspaces, header.area,
+                       header.layouts) < 0) {
+    gf_trace_close(&trace);
+    return -1;
+  }
+  pipeline.max_windows = header.max_windows;
+
+  fprintf(out, "# gridflux replay %s area=%dx%d max_windows=%d layouts=%s\n",
+          path, header.area.width, header.area.height, pipeline.max_windows,
+          header.layouts[0] ? header.layouts : "-");
+
+  gf_trace_record record;
+  unsigned long steps = 0;
+  unsigned long long total_ns = 0;
+  int status;
+
+  while ((status = gf_trace_read(&trace, &record)) > 0) {
+    gf_replay before = replay;
+    gf_arena_reset(&pipeline.arena);
+    unsigned long long start = gf_stats_now_ns();
+    gf_replay_step(&pipeline, &record);
+    unsigned long long cost = gf_stats_now_ns() - start;
+
+    // Decisions are printed as they happen, the step line closes them
+    fprintf(out,
+            "step=%lu t_us=%llu input=%s window=0x%lx value=%ld cost_ns=%llu "
+            "configures=%lu moves=%lu unmaximizes=%lu\n",
+            steps, record.time_us, gf_trace_type_name(record.type),
+            record.window, record.value, cost,
+            replay.configures - before.configures, replay.moves - before.moves,
+            replay.unmaximizes - before.unmaximizes);
+    total_ns += cost;
+    steps++;
+  }
+
+  fprintf(out,
+          "# steps=%lu total_ns=%llu configures=%lu moves=%lu unmaximizes=%lu "
+          "workspace_requests=%lu\n",
+          steps, total_ns, replay.configures, replay.moves, replay.unmaximizes,
+          replay.workspace_requests);
+  gf_stats_dump(out);
+
+  gf_pipeline_free(&pipeline);
+  gf_trace_close(&trace);
+  return status < 0 ? -1 : 0;
+}
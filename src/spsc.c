@@ -0,0 +1,130 @@
+#include "spsc.h"
+#include "ewmh.h"
+#include "gridflux.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int gf_spsc_init(gf_spsc *queue, size_t item_size, unsigned long capacity) {
+  memset(queue, 0, sizeof(*queue));
+  queue->wake[0] = queue->wake[1] = -1;
+
+  unsigned long rounded = 16;
+  while (rounded < capacity)
+    rounded *= 2;
+
+  queue->slots = malloc(rounded * item_size);
+  if (!queue->slots) {
+    LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+    return -1;
+  }
+  queue->item_size = item_size;
+  queue->capacity = rounded;
+
+  // Non-blocking both ways: a full pipe already means "wake up"
+  if (pipe(queue->wake) < 0 ||
+      fcntl(queue->wake[0], F_SETFL, O_NONBLOCK) < 0 ||
+      fcntl(queue->wake[1], F_SETFL, O_NONBLOCK) < 0) {
+    LOG(GF_ERR, "Cannot create queue wake pipe: %s", strerror(errno));
+    gf_spsc_free(queue);
+    return -1;
+  }
+  fcntl(queue->wake[0], F_SETFD, FD_CLOEXEC);
+  fcntl(queue->wake[1], F_SETFD, FD_CLOEXEC);
+  return 0;
+}
+
+void gf_spsc_free(gf_spsc *queue) {
+  for (int i = 0; i < 2; i++) {
+    if (queue->wake[i] >= 0)
+      close(queue->wake[i]);
+  }
+  free(queue->slots);
+  free(queue->backlog);
+  memset(queue, 0, sizeof(*queue));
+  queue->wake[0] = queue->wake[1] = -1;
+}
+
+static int gf_spsc_try_push(gf_spsc *queue, const void *item) {
+  unsigned long tail = queue->tail;
+  if (tail - __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) ==
+      queue->capacity)
+    return 0;
+
+  memcpy(queue->slots + (tail & (queue->capacity - 1)) * queue->item_size,
+         item, queue->item_size);
+  __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+int gf_spsc_push(gf_spsc *queue, const void *item) {
+  // Once something waits in the backlog, later items queue behind it
+  if (queue->backlog_count == 0 && gf_spsc_try_push(queue, item)) {
+    queue->unannounced++;
+    return 0;
+  }
+
+  if (queue->backlog_count == queue->backlog_capacity) {
+    unsigned long capacity =
+        queue->backlog_capacity ? queue->backlog_capacity * 2 : 64;
+    unsigned char *grown = realloc(queue->backlog, capacity * queue->item_size);
+    if (!grown) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return -1;
+    }
+    queue->backlog = grown;
+    queue->backlog_capacity = capacity;
+  }
+
+  memcpy(queue->backlog + queue->backlog_count * queue->item_size, item,
+         queue->item_size);
+  queue->backlog_count++;
+  return 0;
+}
+
+unsigned long gf_spsc_publish(gf_spsc *queue) {
+  unsigned long moved = 0;
+  while (moved < queue->backlog_count &&
+         gf_spsc_try_push(queue, queue->backlog + moved * queue->item_size))
+    moved++;
+
+  if (moved) {
+    queue->backlog_count -= moved;
+    memmove(queue->backlog, queue->backlog + moved * queue->item_size,
+            queue->backlog_count * queue->item_size);
+    queue->unannounced += moved;
+  }
+
+  if (queue->unannounced) {
+    gf_spsc_wake(queue);
+    queue->unannounced = 0;
+  }
+  return queue->backlog_count;
+}
+
+void gf_spsc_wake(gf_spsc *queue) {
+  char byte = 0;
+  // EAGAIN leaves a wake pending already, nothing else can go wrong here
+  (void)!write(queue->wake[1], &byte, 1);
+}
+
+int gf_spsc_fd(const gf_spsc *queue) { return queue->wake[0]; }
+
+void gf_spsc_clear(gf_spsc *queue) {
+  char buffer[64];
+  while (read(queue->wake[0], buffer, sizeof(buffer)) > 0)
+    ;
+}
+
+int gf_spsc_pop(gf_spsc *queue, void *item) {
+  unsigned long head = queue->head;
+  if (head == __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE))
+    return 0;
+
+  memcpy(item, queue->slots + (head & (queue->capacity - 1)) * queue->item_size,
+         queue->item_size);
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+  return 1;
+}
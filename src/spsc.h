@@ -0,0 +1,70 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_SPSC
+#define GF_SPSC
+
+#include <stddef.h>
+
+#define GF_SPSC_CACHE_LINE 64
+
+// Bounded single-producer single-consumer ring of fixed-size items. Each
+// index is written by one side only, on its own cache line, and published
+// with release/acquire ordering, so neither side takes a lock. An item that
+// does not fit waits in a backlog private to the producer instead of
+// blocking it; gf_spsc_publish moves what it can into the ring and wakes a
+// consumer sleeping in poll() on gf_spsc_fd.
+typedef struct {
+  unsigned long head; // next slot to read, advanced by the consumer
+  char head_pad[GF_SPSC_CACHE_LINE - sizeof(unsigned long)];
+  unsigned long tail; // next slot to write, advanced by the producer
+  char tail_pad[GF_SPSC_CACHE_LINE - sizeof(unsigned long)];
+
+  unsigned char *slots;
+  size_t item_size;
+  unsigned long capacity; // a power of two
+
+  // Producer side only
+  unsigned char *backlog;
+  unsigned long backlog_count;
+  unsigned long backlog_capacity;
+  unsigned long unannounced;
+
+  int wake[2]; // read end for the consumer, write end for the producer
+} gf_spsc;
+
+int gf_spsc_init(gf_spsc *queue, size_t item_size, unsigned long capacity);
+void gf_spsc_free(gf_spsc *queue);
+
+// Producer: queues a copy of `item`, -1 only when the backlog cannot grow.
+int gf_spsc_push(gf_spsc *queue, const void *item);
+// Producer: makes pushed items visible and wakes the consumer; returns the
+// number still in the backlog, which the producer retries later.
+unsigned long gf_spsc_publish(gf_spsc *queue);
+// Producer: interrupts a consumer waiting on gf_spsc_fd without an item.
+void gf_spsc_wake(gf_spsc *queue);
+
+// Consumer: readable while woken. Drain it with gf_spsc_clear before
+// popping so a wake that races the pops is not lost.
+int gf_spsc_fd(const gf_spsc *queue);
+void gf_spsc_clear(gf_spsc *queue);
+// Consumer: copies the oldest item out; 1 when there was one.
+int gf_spsc_pop(gf_spsc *queue, void *item);
+
+#endif // GF_SPSC
@@ -0,0 +1,130 @@
+#include "state.h"
+#include "gridflux.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define GF_STATE_READ_TRIES 1000000 // an update takes microseconds
+
+int gf_state_path(char *path, size_t size) {
+  const char *configured = getenv("GRIDFLUX_STATE_FILE");
+  const char *runtime = getenv("XDG_RUNTIME_DIR");
+  int length;
+
+  if (configured && *configured)
+    length = snprintf(path, size, "%s", configured);
+  else if (runtime && *runtime)
+    length = snprintf(path, size, "%s/" GF_STATE_FILE_NAME, runtime);
+  else
+    return -1;
+  return length < 0 || (size_t)length >= size ? -1 : 0;
+}
+
+int gf_state_export_open(gf_state_export *export, const char *path) {
+  char staging[sizeof(export->path) + 16];
+
+  export->state = NULL;
+  if (strlen(path) >= sizeof(export->path)) {
+    LOG(GF_WARN, "State file path too long: %s", path);
+    return -1;
+  }
+  snprintf(staging, sizeof(staging), "%s.%d", path, (int)getpid());
+
+  // A leftover from an earlier process with the same pid is ours to drop;
+  // O_EXCL and O_NOFOLLOW then refuse anything planted in between
+  unlink(staging);
+  int fd = open(staging,
+                O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+  if (fd < 0) {
+    LOG(GF_WARN, "Cannot create %s: %s", staging, strerror(errno));
+    return -1;
+  }
+
+  gf_state *state = MAP_FAILED;
+  if (ftruncate(fd, sizeof(gf_state)) == 0)
+    state = mmap(NULL, sizeof(gf_state), PROT_READ | PROT_WRITE, MAP_SHARED,
+                 fd, 0);
+  close(fd);
+  if (state == MAP_FAILED) {
+    LOG(GF_WARN, "Cannot map %s: %s", staging, strerror(errno));
+    unlink(staging);
+    return -1;
+  }
+
+  // ftruncate zeroed the rest: no workspaces, no tiles, sequence 0
+  state->magic = GF_STATE_MAGIC;
+  state->version = GF_STATE_VERSION;
+  state->pid = (int32_t)getpid();
+
+  if (rename(staging, path) < 0) {
+    LOG(GF_WARN, "Cannot publish %s: %s", path, strerror(errno));
+    munmap(state, sizeof(gf_state));
+    unlink(staging);
+    return -1;
+  }
+
+  export->state = state;
+  strcpy(export->path, path);
+  LOG(GF_INFO, "Exporting layout state to %s", path);
+  return 0;
+}
+
+void gf_state_export_close(gf_state_export *export) {
+  if (!export->state)
+    return;
+
+  munmap(export->state, sizeof(gf_state));
+  unlink(export->path);
+  export->state = NULL;
+}
+
+gf_state *gf_state_begin(gf_state_export *export) {
+  gf_state *state = export->state;
+  if (!state)
+    return NULL;
+
+  // Odd first, and before any of the writes that follow become visible
+  __atomic_store_n(&state->sequence, state->sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  return state;
+}
+
+void gf_state_end(gf_state_export *export) {
+  gf_state *state = export->state;
+  __atomic_store_n(&state->sequence, state->sequence + 1, __ATOMIC_RELEASE);
+}
+
+const gf_state *gf_state_map(const char *path) {
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+
+  gf_state *state = mmap(NULL, sizeof(gf_state), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  return state == MAP_FAILED ? NULL : state;
+}
+
+void gf_state_unmap(const gf_state *state) {
+  munmap((void *)state, sizeof(gf_state));
+}
+
+int gf_state_read(const gf_state *state, gf_state *copy) {
+  if (state->magic != GF_STATE_MAGIC || state->version != GF_STATE_VERSION)
+    return -1;
+
+  for (long tries = 0; tries < GF_STATE_READ_TRIES; tries++) {
+    uint64_t before = __atomic_load_n(&state->sequence, __ATOMIC_ACQUIRE);
+    if (before & 1)
+      continue;
+
+    memcpy(copy, state, sizeof(*copy));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&state->sequence, __ATOMIC_RELAXED) == before)
+      return 0;
+  }
+  return -1;
+}
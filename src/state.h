@@ -0,0 +1,97 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_STATE
+#define GF_STATE
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GF_STATE_MAGIC 0x54534647u // "GFST" read as little-endian bytes
+#define GF_STATE_VERSION 1
+#define GF_STATE_FILE_NAME "gridflux.state"
+#define GF_STATE_MAX_WORKSPACES 32
+#define GF_STATE_MAX_TILES 512
+
+typedef struct {
+  uint32_t layout;     // gf_layout_kind
+  uint32_t windows;    // managed windows on the workspace
+  uint32_t first_tile; // its tiles are tiles[first_tile, first_tile + tiles)
+  uint32_t tiles;
+} gf_state_workspace;
+
+// The last rect committed for a window, decorations included.
+typedef struct {
+  uint64_t window;
+  int32_t workspace;
+  int32_t output;
+  int32_t x;
+  int32_t y;
+  int32_t width;
+  int32_t height;
+} gf_state_tile;
+
+// The layout model as of the last planner cycle, in a file only its owner
+// can open (mode 0600), which readers map read-only. `sequence` is a
+// seqlock: odd while the planner rewrites the rest, bumped to the next even
+// value once it is done. A reader copies the state between two loads of an
+// even, unchanged sequence, see gf_state_read; no syscall and no X request
+// is involved.
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t sequence;
+  int32_t pid; // of the writer, to tell a stale file from a live one
+  uint32_t paused;
+  uint32_t capacity; // tiles per workspace, 0 for no limit
+  uint32_t windows;  // managed in total
+  uint32_t workspace_count;
+  uint32_t tile_count;
+  uint32_t truncated; // more workspaces or tiles than fit below
+  uint32_t reserved;
+  gf_state_workspace workspaces[GF_STATE_MAX_WORKSPACES];
+  gf_state_tile tiles[GF_STATE_MAX_TILES];
+} gf_state;
+
+typedef struct {
+  gf_state *state;
+  char path[108];
+} gf_state_export;
+
+// GRIDFLUX_STATE_FILE, else gridflux.state in $XDG_RUNTIME_DIR. Returns -1
+// when neither is set or the path does not fit.
+int gf_state_path(char *path, size_t size);
+
+// Writer side. The file appears fully sized and initialized, under its
+// final name only once it is, so a reader never maps a short file. Only
+// its owner can read it.
+int gf_state_export_open(gf_state_export *export, const char *path);
+void gf_state_export_close(gf_state_export *export);
+// Brackets one update; gf_state_begin returns NULL when not exporting.
+gf_state *gf_state_begin(gf_state_export *export);
+void gf_state_end(gf_state_export *export);
+
+// Reader side: maps an exported file read-only, NULL when there is none.
+const gf_state *gf_state_map(const char *path);
+void gf_state_unmap(const gf_state *state);
+// Takes a consistent copy; -1 when the file is not a state this reader
+// understands or its writer died halfway through an update.
+int gf_state_read(const gf_state *state, gf_state *copy);
+
+#endif // GF_STATE
@@ -0,0 +1,158 @@
+#include "stats.h"
+#include "gridflux.h"
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+  unsigned long requests[GF_REQ_COUNT];
+  unsigned long round_trips;
+  unsigned long runs;
+  unsigned long long total_ns;
+  unsigned long long max_ns;
+  unsigned long histogram[GF_STATS_BUCKETS];
+} gf_stage_stats;
+
+static const char *stage_names[GF_STAGE_COUNT] = {
+    [GF_STAGE_EVENT] = "event",       [GF_STAGE_FETCH] = "fetch",
+    [GF_STAGE_FILTER] = "filter",     [GF_STAGE_OVERFLOW] = "overflow",
+    [GF_STAGE_ARRANGE] = "arrange",   [GF_STAGE_COMMIT] = "commit",
+    [GF_STAGE_PASS] = "pass",         [GF_STAGE_APPLY] = "apply",
+};
+
+static const char *request_names[GF_REQ_COUNT] = {
+    [GF_REQ_GET_PROPERTY] = "get_property",
+    [GF_REQ_CHANGE_PROPERTY] = "change_property",
+    [GF_REQ_GET_GEOMETRY] = "get_geometry",
+    [GF_REQ_CONFIGURE] = "configure",
+    [GF_REQ_SEND_EVENT] = "send_event",
+    [GF_REQ_SELECT_INPUT] = "select_input",
+    [GF_REQ_INTERN_ATOM] = "intern_atom",
+    [GF_REQ_FLUSH] = "flush",
+    [GF_REQ_SYNC] = "sync",
+};
+
+static gf_stage_stats stages[GF_STAGE_COUNT];
+static __thread gf_stage current_stage = GF_STAGE_EVENT;
+static unsigned long long first_tile_ns;
+static unsigned long first_tile_round_trips;
+static int dump_at_exit;
+static volatile sig_atomic_t report_requested;
+
+static void gf_stats_on_signal(int signal) {
+  (void)signal;
+  report_requested = 1;
+}
+
+void gf_stats_init(int dump_on_exit) {
+  memset(stages, 0, sizeof(stages));
+  dump_at_exit = dump_on_exit;
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = gf_stats_on_signal;
+  sigemptyset(&action.sa_mask);
+  // No SA_RESTART: the blocked poll() has to wake up to print the report
+  sigaction(SIGUSR1, &action, NULL);
+}
+
+unsigned long long gf_stats_now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void gf_stats_request(gf_request_kind kind, int round_trip) {
+  stages[current_stage].requests[kind]++;
+  if (round_trip)
+    stages[current_stage].round_trips++;
+}
+
+void gf_stats_round_trip(void) { stages[current_stage].round_trips++; }
+
+gf_stats_scope gf_stats_begin(gf_stage stage) {
+  gf_stats_scope scope = {stage, current_stage, gf_stats_now_ns()};
+  current_stage = stage;
+  return scope;
+}
+
+void gf_stats_end(gf_stats_scope *scope) {
+  unsigned long long elapsed = gf_stats_now_ns() - scope->start_ns;
+  gf_stage_stats *stats = &stages[scope->stage];
+
+  stats->runs++;
+  stats->total_ns += elapsed;
+  if (elapsed > stats->max_ns)
+    stats->max_ns = elapsed;
+
+  // Bucket i holds latencies in [2^i, 2^(i+1)) microseconds
+  unsigned long long us = elapsed / 1000;
+  int bucket = 0;
+  while (us > 1 && bucket < GF_STATS_BUCKETS - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  stats->histogram[bucket]++;
+
+  current_stage = scope->previous;
+}
+
+unsigned long gf_stats_total_requests(void) {
+  unsigned long total = 0;
+  for (int stage = 0; stage < GF_STAGE_COUNT; stage++) {
+    // Flushes write buffered requests, they are not requests themselves
+    for (int kind = 0; kind < GF_REQ_FLUSH; kind++)
+      total += stages[stage].requests[kind];
+    total += stages[stage].requests[GF_REQ_SYNC];
+  }
+  return total;
+}
+
+unsigned long gf_stats_total_round_trips(void) {
+  unsigned long total = 0;
+  for (int stage = 0; stage < GF_STAGE_COUNT; stage++)
+    total += stages[stage].round_trips;
+  return total;
+}
+
+void gf_stats_first_tile(unsigned long long elapsed_ns) {
+  first_tile_ns = elapsed_ns;
+  first_tile_round_trips = gf_stats_total_round_trips();
+  LOG(GF_INFO, "First tile after %.2f ms and %lu round trips",
+      elapsed_ns / 1e6, first_tile_round_trips);
+}
+
+void gf_stats_dump(FILE *out) {
+  fprintf(out, "# gridflux stats\n");
+  for (int stage = 0; stage < GF_STAGE_COUNT; stage++) {
+    const gf_stage_stats *stats = &stages[stage];
+
+    fprintf(out, "stage=%s runs=%lu round_trips=%lu total_us=%llu max_us=%llu",
+            stage_names[stage], stats->runs, stats->round_trips,
+            stats->total_ns / 1000, stats->max_ns / 1000);
+    for (int kind = 0; kind < GF_REQ_COUNT; kind++)
+      fprintf(out, " %s=%lu", request_names[kind], stats->requests[kind]);
+
+    fprintf(out, " hist_us=");
+    for (int bucket = 0; bucket < GF_STATS_BUCKETS; bucket++)
+      fprintf(out, "%s%lu", bucket ? "," : "", stats->histogram[bucket]);
+    fprintf(out, "\n");
+  }
+  if (first_tile_ns)
+    fprintf(out, "startup first_tile_us=%llu round_trips=%lu\n",
+            first_tile_ns / 1000, first_tile_round_trips);
+  fflush(out);
+}
+
+void gf_stats_poll_report(void) {
+  if (!report_requested)
+    return;
+
+  report_requested = 0;
+  gf_stats_dump(stderr);
+}
+
+void gf_stats_finish(void) {
+  if (dump_at_exit)
+    gf_stats_dump(stderr);
+}
@@ -0,0 +1,80 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_STATS
+#define GF_STATS
+
+#include <stdio.h>
+
+#define GF_STATS_BUCKETS 24
+
+typedef enum {
+  GF_STAGE_EVENT,
+  GF_STAGE_FETCH,
+  GF_STAGE_FILTER,
+  GF_STAGE_OVERFLOW,
+  GF_STAGE_ARRANGE,
+  GF_STAGE_COMMIT,
+  GF_STAGE_PASS,
+  GF_STAGE_APPLY,
+  GF_STAGE_COUNT
+} gf_stage;
+
+typedef enum {
+  GF_REQ_GET_PROPERTY,
+  GF_REQ_CHANGE_PROPERTY,
+  GF_REQ_GET_GEOMETRY,
+  GF_REQ_CONFIGURE,
+  GF_REQ_SEND_EVENT,
+  GF_REQ_SELECT_INPUT,
+  GF_REQ_INTERN_ATOM,
+  GF_REQ_FLUSH,
+  GF_REQ_SYNC,
+  GF_REQ_COUNT
+} gf_request_kind;
+
+typedef struct {
+  gf_stage stage;
+  gf_stage previous;
+  unsigned long long start_ns;
+} gf_stats_scope;
+
+// Plain counters: a handful of increments and one vDSO clock read per
+// stage, cheap enough to stay enabled in production. The current stage is
+// per thread; the X thread and the planner never run the same stage, so no
+// counter has two writers.
+void gf_stats_init(int dump_on_exit);
+void gf_stats_request(gf_request_kind kind, int round_trip);
+void gf_stats_round_trip(void);
+
+gf_stats_scope gf_stats_begin(gf_stage stage);
+void gf_stats_end(gf_stats_scope *scope);
+
+unsigned long long gf_stats_now_ns(void);
+unsigned long gf_stats_total_requests(void);
+unsigned long gf_stats_total_round_trips(void);
+
+// Time from startup until the first layout pass was flushed to the server
+void gf_stats_first_tile(unsigned long long elapsed_ns);
+
+void gf_stats_dump(FILE *out);
+void gf_stats_poll_report(void);
+void gf_stats_finish(void);
+
+#endif // GF_STATS
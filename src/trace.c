@@ -0,0 +1,373 @@
+#include "trace.h"
+#include "ewmh.h"
+#include "gridflux.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char trace_magic[8] = {'G', 'F', 'T', 'R', 'A', 'C', 'E', 0};
+
+static const char *trace_type_names[] = {
+    [GF_TRACE_CLIENT_LIST] = "client_list", [GF_TRACE_CLIENT] = "client",
+    [GF_TRACE_CONFIGURE] = "configure",     [GF_TRACE_DESTROY] = "destroy",
+    [GF_TRACE_MARK] = "mark",               [GF_TRACE_MARK_ALL] = "mark_all",
+    [GF_TRACE_PASS] = "pass",               [GF_TRACE_OUTPUTS] = "outputs",
+    [GF_TRACE_HINTS] = "hints",             [GF_TRACE_FRAME] = "frame",
+    [GF_TRACE_SYNC] = "sync",               [GF_TRACE_RELAYOUT] = "relayout",
+    [GF_TRACE_LAYOUT] = "layout",           [GF_TRACE_CAPACITY] = "capacity",
+    [GF_TRACE_PAUSE] = "pause",
+};
+
+const char *gf_trace_type_name(gf_trace_type type) {
+  if (type < GF_TRACE_CLIENT_LIST || type > GF_TRACE_PAUSE)
+    return "unknown";
+  return trace_type_names[type];
+}
+
+static void gf_trace_put(FILE *file, unsigned long long value) {
+  // LEB128: seven bits per byte, high bit set while more follow
+  do {
+    unsigned char byte = value & 0x7f;
+    value >>= 7;
+    fputc(value ? byte | 0x80 : byte, file);
+  } while (value);
+}
+
+static void gf_trace_put_signed(FILE *file, long long value) {
+  // Zigzag keeps small negatives such as GF_DESKTOP_UNKNOWN to one byte
+  gf_trace_put(file, ((unsigned long long)value << 1) ^ (value >> 63));
+}
+
+static int gf_trace_get(FILE *file, unsigned long long *value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int byte = fgetc(file);
+    if (byte == EOF)
+      return -1;
+
+    *value |= (unsigned long long)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return 0;
+  }
+  return -1;
+}
+
+static int gf_trace_get_signed(FILE *file, long long *value) {
+  unsigned long long raw;
+  if (gf_trace_get(file, &raw) < 0)
+    return -1;
+
+  *value = (long long)(raw >> 1) ^ -(long long)(raw & 1);
+  return 0;
+}
+
+static void gf_trace_put_rect(FILE *file, gf_rect rect) {
+  gf_trace_put_signed(file, rect.x);
+  gf_trace_put_signed(file, rect.y);
+  gf_trace_put_signed(file, rect.width);
+  gf_trace_put_signed(file, rect.height);
+}
+
+static int gf_trace_get_rect(FILE *file, gf_rect *rect) {
+  long long x, y, width, height;
+  if (gf_trace_get_signed(file, &x) < 0 || gf_trace_get_signed(file, &y) < 0 ||
+      gf_trace_get_signed(file, &width) < 0 ||
+      gf_trace_get_signed(file, &height) < 0)
+    return -1;
+
+  *rect = (gf_rect){(int)x, (int)y, (int)width, (int)height};
+  return 0;
+}
+
+static void gf_trace_put_hints(FILE *file, const gf_size_hints *hints) {
+  gf_trace_put_signed(file, hints->min_width);
+  gf_trace_put_signed(file, hints->min_height);
+  gf_trace_put_signed(file, hints->max_width);
+  gf_trace_put_signed(file, hints->max_height);
+  gf_trace_put_signed(file, hints->base_width);
+  gf_trace_put_signed(file, hints->base_height);
+  gf_trace_put_signed(file, hints->width_inc);
+  gf_trace_put_signed(file, hints->height_inc);
+  gf_trace_put_signed(file, hints->gravity);
+}
+
+static int gf_trace_get_hints(FILE *file, gf_size_hints *hints) {
+  int *fields[] = {&hints->min_width,  &hints->min_height, &hints->max_width,
+                   &hints->max_height, &hints->base_width, &hints->base_height,
+                   &hints->width_inc,  &hints->height_inc, &hints->gravity};
+  long long value;
+
+  for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+    if (gf_trace_get_signed(file, &value) < 0)
+      return -1;
+    *fields[i] = (int)value;
+  }
+  return 0;
+}
+
+int gf_trace_open_write(gf_trace *trace, const char *path,
+                        const gf_trace_header *header) {
+  memset(trace, 0, sizeof(*trace));
+  trace->file = fopen(path, "wb");
+  if (!trace->file) {
+    LOG(GF_ERR, "Cannot open trace %s for writing", path);
+    return -1;
+  }
+
+  size_t layouts = strlen(header->layouts);
+  fwrite(trace_magic, 1, sizeof(trace_magic), trace->file);
+  gf_trace_put(trace->file, GF_TRACE_VERSION);
+  gf_trace_put_rect(trace->file, header->area);
+  gf_trace_put(trace->file, header->max_windows);
+  gf_trace_put(trace->file, layouts);
+  fwrite(header->layouts, 1, layouts, trace->file);
+
+  trace->start_ns = gf_stats_now_ns();
+  return 0;
+}
+
+int gf_trace_open_read(gf_trace *trace, const char *path,
+                       gf_trace_header *header) {
+  char magic[sizeof(trace_magic)];
+  unsigned long long version, max_windows, layouts;
+
+  memset(trace, 0, sizeof(*trace));
+  memset(header, 0, sizeof(*header));
+  trace->file = fopen(path, "rb");
+  if (!trace->file) {
+    LOG(GF_ERR, "Cannot open trace %s", path);
+    return -1;
+  }
+
+  if (fread(magic, 1, sizeof(magic), trace->file) != sizeof(magic) ||
+      memcmp(magic, trace_magic, sizeof(magic)) != 0 ||
+      gf_trace_get(trace->file, &version) < 0 ||
+      version != GF_TRACE_VERSION ||
+      gf_trace_get_rect(trace->file, &header->area) < 0 ||
+      gf_trace_get(trace->file, &max_windows) < 0 ||
+      gf_trace_get(trace->file, &layouts) < 0 ||
+      layouts >= sizeof(header->layouts) ||
+      fread(header->layouts, 1, layouts, trace->file) != layouts) {
+    LOG(GF_ERR, "%s is not a gridflux trace (version %d)", path,
+        GF_TRACE_VERSION);
+    gf_trace_close(trace);
+    return -1;
+  }
+
+  header->max_windows = (int)max_windows;
+  header->layouts[layouts] = '\0';
+  return 0;
+}
+
+int gf_trace_write(gf_trace *trace, const gf_trace_record *record) {
+  if (!trace || !trace->file)
+    return -1;
+
+  unsigned long long now_us = (gf_stats_now_ns() - trace->start_ns) / 1000;
+  FILE *file = trace->file;
+
+  fputc(record->type, file);
+  gf_trace_put(file, now_us - trace->last_us);
+  trace->last_us = now_us;
+
+  switch (record->type) {
+  case GF_TRACE_CLIENT_LIST:
+    gf_trace_put(file, record->count);
+    for (unsigned long i = 0; i < record->count; i++)
+      gf_trace_put(file, record->windows[i]);
+    break;
+  case GF_TRACE_CLIENT:
+    gf_trace_put(file, record->window);
+    gf_trace_put_signed(file, record->value);
+    gf_trace_put(file, record->flags);
+    gf_trace_put_rect(file, record->rect);
+    break;
+  case GF_TRACE_CONFIGURE:
+    gf_trace_put(file, record->window);
+    gf_trace_put_rect(file, record->rect);
+    break;
+  case GF_TRACE_DESTROY:
+  case GF_TRACE_SYNC:
+    gf_trace_put(file, record->window);
+    break;
+  case GF_TRACE_MARK:
+  case GF_TRACE_MARK_ALL:
+  case GF_TRACE_RELAYOUT:
+  case GF_TRACE_CAPACITY:
+  case GF_TRACE_PAUSE:
+    gf_trace_put_signed(file, record->value);
+    break;
+  case GF_TRACE_LAYOUT:
+    gf_trace_put_signed(file, record->value);
+    gf_trace_put(file, record->flags);
+    break;
+  case GF_TRACE_PASS:
+    gf_trace_put_signed(file, record->value);
+    // A pass ends a batch; keep the trace usable if we crash after it
+    fflush(file);
+    break;
+  case GF_TRACE_OUTPUTS:
+    gf_trace_put(file, record->count);
+    for (unsigned long i = 0; i < record->count; i++)
+      gf_trace_put_rect(file, record->rects[i]);
+    break;
+  case GF_TRACE_HINTS:
+    gf_trace_put(file, record->window);
+    gf_trace_put_hints(file, &record->hints);
+    break;
+  case GF_TRACE_FRAME:
+    gf_trace_put(file, record->window);
+    gf_trace_put_rect(file, (gf_rect){record->frame.left, record->frame.right,
+                                      record->frame.top, record->frame.bottom});
+    break;
+  }
+
+  return ferror(file) ? -1 : 0;
+}
+
+static int gf_trace_read_windows(gf_trace *trace, gf_trace_record *record) {
+  unsigned long long count, window;
+  if (gf_trace_get(trace->file, &count) < 0)
+    return -1;
+
+  if (count > trace->capacity) {
+    Window *windows = realloc(trace->windows, count * sizeof(*windows));
+    if (!windows) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return -1;
+    }
+    trace->windows = windows;
+    trace->capacity = count;
+  }
+
+  for (unsigned long long i = 0; i < count; i++) {
+    if (gf_trace_get(trace->file, &window) < 0)
+      return -1;
+    trace->windows[i] = (Window)window;
+  }
+
+  record->windows = trace->windows;
+  record->count = count;
+  return 0;
+}
+
+static int gf_trace_read_rects(gf_trace *trace, gf_trace_record *record) {
+  unsigned long long count;
+  if (gf_trace_get(trace->file, &count) < 0)
+    return -1;
+
+  if (count > trace->rect_capacity) {
+    gf_rect *rects = realloc(trace->rects, count * sizeof(*rects));
+    if (!rects) {
+      LOG(GF_ERR, ERR_FAIL_ALLOCATE);
+      return -1;
+    }
+    trace->rects = rects;
+    trace->rect_capacity = count;
+  }
+
+  for (unsigned long long i = 0; i < count; i++) {
+    if (gf_trace_get_rect(trace->file, &trace->rects[i]) < 0)
+      return -1;
+  }
+
+  record->rects = trace->rects;
+  record->count = count;
+  return 0;
+}
+
+int gf_trace_read(gf_trace *trace, gf_trace_record *record) {
+  unsigned long long delta, window = 0, flags = 0;
+  long long value = 0;
+  int status = 0;
+
+  memset(record, 0, sizeof(*record));
+  int type = fgetc(trace->file);
+  if (type == EOF)
+    return 0;
+
+  if (gf_trace_get(trace->file, &delta) < 0)
+    return -1;
+  trace->last_us += delta;
+  record->time_us = trace->last_us;
+  record->type = (gf_trace_type)type;
+
+  switch (record->type) {
+  case GF_TRACE_CLIENT_LIST:
+    status = gf_trace_read_windows(trace, record);
+    break;
+  case GF_TRACE_CLIENT:
+    status = gf_trace_get(trace->file, &window) < 0 ||
+                     gf_trace_get_signed(trace->file, &value) < 0 ||
+                     gf_trace_get(trace->file, &flags) < 0 ||
+                     gf_trace_get_rect(trace->file, &record->rect) < 0
+                 ? -1
+                 : 0;
+    break;
+  case GF_TRACE_CONFIGURE:
+    status = gf_trace_get(trace->file, &window) < 0 ||
+                     gf_trace_get_rect(trace->file, &record->rect) < 0
+                 ? -1
+                 : 0;
+    break;
+  case GF_TRACE_DESTROY:
+  case GF_TRACE_SYNC:
+    status = gf_trace_get(trace->file, &window);
+    break;
+  case GF_TRACE_MARK:
+  case GF_TRACE_MARK_ALL:
+  case GF_TRACE_PASS:
+  case GF_TRACE_RELAYOUT:
+  case GF_TRACE_CAPACITY:
+  case GF_TRACE_PAUSE:
+    status = gf_trace_get_signed(trace->file, &value);
+    break;
+  case GF_TRACE_LAYOUT:
+    status = gf_trace_get_signed(trace->file, &value) < 0 ||
+                     gf_trace_get(trace->file, &flags) < 0
+                 ? -1
+                 : 0;
+    break;
+  case GF_TRACE_OUTPUTS:
+    status = gf_trace_read_rects(trace, record);
+    break;
+  case GF_TRACE_HINTS:
+    status = gf_trace_get(trace->file, &window) < 0 ||
+                     gf_trace_get_hints(trace->file, &record->hints) < 0
+                 ? -1
+                 : 0;
+    break;
+  case GF_TRACE_FRAME: {
+    gf_rect sides = {0};
+    status = gf_trace_get(trace->file, &window) < 0 ||
+                     gf_trace_get_rect(trace->file, &sides) < 0
+                 ? -1
+                 : 0;
+    if (status == 0)
+      record->frame =
+          (gf_frame_extents){sides.x, sides.y, sides.width, sides.height};
+    break;
+  }
+  default:
+    status = -1;
+    break;
+  }
+
+  if (status < 0) {
+    LOG(GF_ERR, "Truncated or corrupt trace record (type %d)", type);
+    return -1;
+  }
+
+  record->window = (Window)window;
+  record->value = (long)value;
+  record->flags = (unsigned int)flags;
+  return 1;
+}
+
+void gf_trace_close(gf_trace *trace) {
+  if (trace->file)
+    fclose(trace->file);
+  free(trace->windows);
+  free(trace->rects);
+  memset(trace, 0, sizeof(*trace));
+}
@@ -0,0 +1,94 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_TRACE
+#define GF_TRACE
+
+#include "client.h"
+#include "layout.h"
+#include <X11/X.h>
+#include <stdio.h>
+
+#define GF_TRACE_VERSION 1
+
+typedef enum {
+  GF_TRACE_CLIENT_LIST = 1, // windows: new _NET_CLIENT_LIST
+  GF_TRACE_CLIENT,          // window, value (desktop), flags, rect (geometry)
+  GF_TRACE_CONFIGURE,       // window, rect
+  GF_TRACE_DESTROY,         // window
+  GF_TRACE_MARK,            // value: workspace made dirty
+  GF_TRACE_MARK_ALL,        // value: workspace count made dirty
+  GF_TRACE_PASS,            // value: workspace count seen by the layout pass
+  GF_TRACE_OUTPUTS,         // rects: usable area of each monitor
+  GF_TRACE_HINTS,           // window, hints; follows its CLIENT record
+  GF_TRACE_FRAME,           // window, frame; follows its CLIENT record
+  GF_TRACE_SYNC,            // window: answered or gave up on a sync request
+  GF_TRACE_RELAYOUT,        // value: workspace retiled from scratch, -1 all
+  GF_TRACE_LAYOUT,          // value: workspace, flags: its gf_layout_kind
+  GF_TRACE_CAPACITY,        // value: new window limit per workspace
+  GF_TRACE_PAUSE,           // value: 1 stops laying out, 0 resumes
+} gf_trace_type;
+
+// One input observed by the layout pipeline. `windows` and `rects` are only
+// valid until the next read from the same trace.
+typedef struct {
+  gf_trace_type type;
+  unsigned long long time_us;
+  Window window;
+  long value;
+  unsigned int flags;
+  gf_rect rect;
+  gf_size_hints hints;
+  gf_frame_extents frame;
+  Window *windows;
+  gf_rect *rects;
+  unsigned long count;
+} gf_trace_record;
+
+// Settings the recorded session ran with, so a replay makes the same calls.
+typedef struct {
+  gf_rect area;
+  int max_windows;
+  char layouts[256];
+} gf_trace_header;
+
+// Append-only binary trace: a versioned header, then one type byte, a
+// varint time delta and varint fields per record.
+typedef struct {
+  FILE *file;
+  unsigned long long start_ns;
+  unsigned long long last_us;
+
+  Window *windows;
+  unsigned long capacity;
+  gf_rect *rects;
+  unsigned long rect_capacity;
+} gf_trace;
+
+int gf_trace_open_write(gf_trace *trace, const char *path,
+                        const gf_trace_header *header);
+int gf_trace_open_read(gf_trace *trace, const char *path,
+                       gf_trace_header *header);
+int gf_trace_write(gf_trace *trace, const gf_trace_record *record);
+int gf_trace_read(gf_trace *trace, gf_trace_record *record);
+void gf_trace_close(gf_trace *trace);
+
+const char *gf_trace_type_name(gf_trace_type type);
+
+#endif // GF_TRACE
@@ -0,0 +1,32 @@
+#include "workspace.h"
+#include "gridflux.h"
+
+void gf_workspace_provisioner_init(gf_workspace_provisioner *provisioner,
+                                   gf_workspace_backend backend) {
+  provisioner->backend = backend;
+  provisioner->requested = 0;
+}
+
+int gf_workspace_provision(gf_workspace_provisioner *provisioner,
+                           unsigned long current, unsigned long wanted) {
+  if (current >= provisioner->requested)
+    provisioner->requested = 0;
+
+  // Already there, or the same request is still in flight
+  if (wanted <= current || wanted <= provisioner->requested)
+    return 0;
+
+  if (!provisioner->backend.request) {
+    return -1;
+  }
+
+  LOG(GF_DBG, "Requesting %lu workspaces from %s (have %lu)", wanted,
+      provisioner->backend.name, current);
+
+  if (provisioner->backend.request(provisioner->backend.user_data, current,
+                                   wanted) < 0)
+    return -1;
+
+  provisioner->requested = wanted;
+  return 0;
+}
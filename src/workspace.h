@@ -0,0 +1,47 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_WORKSPACE
+#define GF_WORKSPACE
+
+// Asks the running desktop for more workspaces. Returns 0 once the request
+// has been sent; the new count is observed later through the usual events.
+typedef int (*gf_workspace_request_func)(void *user_data, unsigned long current,
+                                         unsigned long wanted);
+
+typedef struct {
+  const char *name;
+  gf_workspace_request_func request;
+  void *user_data;
+} gf_workspace_backend;
+
+typedef struct {
+  gf_workspace_backend backend;
+  unsigned long requested;
+} gf_workspace_provisioner;
+
+void gf_workspace_provisioner_init(gf_workspace_provisioner *provisioner,
+                                   gf_workspace_backend backend);
+int gf_workspace_provision(gf_workspace_provisioner *provisioner,
+                           unsigned long current, unsigned long wanted);
+
+// In-process KWin client over the session bus, -1 when unavailable.
+int gf_kwin_backend_init(gf_workspace_backend *backend);
+
+#endif // GF_WORKSPACE
@@ -0,0 +1,361 @@
+#include "xbatch.h"
+#include "ewmh.h"
+#include "gridflux.h"
+#include "stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  xcb_get_property_cookie_t state;
+  xcb_get_property_cookie_t desktop;
+  xcb_get_property_cookie_t hints;
+  xcb_get_property_cookie_t frame;
+  xcb_get_property_cookie_t shadow;
+  xcb_get_property_cookie_t protocols;
+  xcb_get_property_cookie_t counter;
+  xcb_get_geometry_cookie_t geometry;
+  xcb_translate_coordinates_cookie_t position;
+} wm_xcb_client_cookies;
+
+static xcb_get_property_reply_t *
+wm_xcb_property_reply(xcb_connection_t *conn, xcb_get_property_cookie_t cookie) {
+  xcb_generic_error_t *error = NULL;
+  xcb_get_property_reply_t *reply =
+      xcb_get_property_reply(conn, cookie, &error);
+
+  if (error) {
+    free(error);
+    free(reply);
+    return NULL;
+  }
+
+  if (reply && xcb_get_property_value_length(reply) <= 0) {
+    free(reply);
+    return NULL;
+  }
+
+  return reply;
+}
+
+static xcb_get_property_cookie_t
+wm_xcb_get_property(xcb_connection_t *conn, Window window, Atom property,
+                    xcb_atom_t type, uint32_t length) {
+  gf_stats_request(GF_REQ_GET_PROPERTY, 0);
+  return xcb_get_property(conn, 0, (xcb_window_t)window, (xcb_atom_t)property,
+                          type, 0, length);
+}
+
+static Window *wm_xcb_window_list_reply(xcb_connection_t *conn,
+                                        gf_arena *arena,
+                                        xcb_get_property_cookie_t cookie,
+                                        unsigned long *nitems) {
+  xcb_get_property_reply_t *reply = wm_xcb_property_reply(conn, cookie);
+  if (!reply)
+    return NULL;
+
+  int count = xcb_get_property_value_length(reply) / sizeof(xcb_window_t);
+  xcb_window_t *values = xcb_get_property_value(reply);
+
+  Window *windows = gf_arena_alloc(arena, sizeof(Window) * count);
+  if (!windows) {
+    free(reply);
+    return NULL;
+  }
+
+  for (int i = 0; i < count; i++)
+    windows[i] = values[i];
+
+  *nitems = count;
+  free(reply);
+  return windows;
+}
+
+Window *wm_xcb_get_window_list(xcb_connection_t *conn, gf_arena *arena,
+                               Window window, Atom property,
+                               unsigned long *nitems) {
+  *nitems = 0;
+  if (!conn || property == None)
+    return NULL;
+
+  xcb_get_property_cookie_t cookie =
+      wm_xcb_get_property(conn, window, property, XCB_ATOM_WINDOW, UINT32_MAX);
+  gf_stats_round_trip();
+  return wm_xcb_window_list_reply(conn, arena, cookie, nitems);
+}
+
+void wm_xcb_request_root(xcb_connection_t *conn, Window root,
+                         wm_xcb_root_cookies *cookies) {
+  memset(cookies, 0, sizeof(*cookies));
+  if (!conn)
+    return;
+
+  if (atoms.client_list != None)
+    cookies->client_list = wm_xcb_get_property(
+        conn, root, atoms.client_list, XCB_ATOM_WINDOW, UINT32_MAX);
+  if (atoms.num_of_desktop != None)
+    cookies->desktop_count = wm_xcb_get_property(
+        conn, root, atoms.num_of_desktop, XCB_ATOM_CARDINAL, 1);
+  if (atoms.net_curr_desktop != None)
+    cookies->current_desktop = wm_xcb_get_property(
+        conn, root, atoms.net_curr_desktop, XCB_ATOM_CARDINAL, 1);
+  if (atoms.net_workarea != None)
+    cookies->workarea = wm_xcb_get_property(conn, root, atoms.net_workarea,
+                                            XCB_ATOM_CARDINAL, 4);
+  xcb_flush(conn);
+}
+
+static int wm_xcb_cardinal_reply(xcb_connection_t *conn,
+                                 xcb_get_property_cookie_t cookie,
+                                 uint32_t *values, int count) {
+  xcb_get_property_reply_t *reply = wm_xcb_property_reply(conn, cookie);
+  if (!reply)
+    return -1;
+
+  int available = xcb_get_property_value_length(reply) / sizeof(uint32_t);
+  if (available >= count)
+    memcpy(values, xcb_get_property_value(reply), count * sizeof(uint32_t));
+  free(reply);
+  return available >= count ? 0 : -1;
+}
+
+void wm_xcb_collect_root(xcb_connection_t *conn, gf_arena *arena,
+                         const wm_xcb_root_cookies *cookies,
+                         wm_xcb_root_state *state) {
+  uint32_t values[4];
+
+  memset(state, 0, sizeof(*state));
+  state->current_desktop = -1;
+  if (!conn)
+    return;
+
+  // Whatever the caller did since the request already waited for these
+  gf_stats_round_trip();
+
+  if (atoms.client_list != None)
+    state->clients = wm_xcb_window_list_reply(
+        conn, arena, cookies->client_list, &state->client_count);
+  if (atoms.num_of_desktop != None &&
+      wm_xcb_cardinal_reply(conn, cookies->desktop_count, values, 1) == 0)
+    state->desktop_count = values[0];
+  if (atoms.net_curr_desktop != None &&
+      wm_xcb_cardinal_reply(conn, cookies->current_desktop, values, 1) == 0)
+    state->current_desktop = values[0];
+  if (atoms.net_workarea != None &&
+      wm_xcb_cardinal_reply(conn, cookies->workarea, values, 4) == 0) {
+    state->workarea = (gf_rect){(int)values[0], (int)values[1],
+                                (int)values[2], (int)values[3]};
+    state->has_workarea = 1;
+  }
+}
+
+static int wm_xcb_has_atom(xcb_connection_t *conn,
+                           xcb_get_property_cookie_t cookie, Atom atom) {
+  xcb_get_property_reply_t *reply = wm_xcb_property_reply(conn, cookie);
+  if (!reply)
+    return 0;
+
+  int count = xcb_get_property_value_length(reply) / sizeof(xcb_atom_t);
+  xcb_atom_t *values = xcb_get_property_value(reply);
+  int found = 0;
+  for (int i = 0; i < count && !found; i++)
+    found = values[i] == (xcb_atom_t)atom;
+
+  free(reply);
+  return found;
+}
+
+static unsigned int wm_xcb_state_flags(xcb_get_property_reply_t *reply) {
+  if (!reply)
+    return 0;
+
+  int count = xcb_get_property_value_length(reply) / sizeof(xcb_atom_t);
+  xcb_atom_t *states = xcb_get_property_value(reply);
+
+  for (int i = 0; i < count; i++) {
+    if (gf_excluded_state(states[i]))
+      return GF_CLIENT_EXCLUDED;
+  }
+  return 0;
+}
+
+// WM_SIZE_HINTS flags and field offsets from ICCCM 4.1.2.3
+#define WM_XCB_HINTS_MIN (1 << 4)
+#define WM_XCB_HINTS_MAX (1 << 5)
+#define WM_XCB_HINTS_INC (1 << 6)
+#define WM_XCB_HINTS_BASE (1 << 8)
+#define WM_XCB_HINTS_GRAVITY (1 << 9)
+#define WM_XCB_HINTS_LENGTH 18
+
+static gf_size_hints wm_xcb_size_hints(xcb_get_property_reply_t *reply) {
+  gf_size_hints hints = {0};
+  if (!reply)
+    return hints;
+
+  int count = xcb_get_property_value_length(reply) / sizeof(uint32_t);
+  int32_t *values = xcb_get_property_value(reply);
+  if (count < 11)
+    return hints;
+
+  uint32_t flags = (uint32_t)values[0];
+  if (flags & WM_XCB_HINTS_MIN) {
+    hints.min_width = values[5];
+    hints.min_height = values[6];
+  }
+  if (flags & WM_XCB_HINTS_MAX) {
+    hints.max_width = values[7];
+    hints.max_height = values[8];
+  }
+  if (flags & WM_XCB_HINTS_INC) {
+    hints.width_inc = values[9];
+    hints.height_inc = values[10];
+  }
+  // Pre-ICCCM clients send 15 fields, without base size and gravity
+  if ((flags & WM_XCB_HINTS_BASE) && count >= 17) {
+    hints.base_width = values[15];
+    hints.base_height = values[16];
+  } else {
+    hints.base_width = hints.min_width;
+    hints.base_height = hints.min_height;
+  }
+  if (!(flags & WM_XCB_HINTS_MIN)) {
+    hints.min_width = hints.base_width;
+    hints.min_height = hints.base_height;
+  }
+  if ((flags & WM_XCB_HINTS_GRAVITY) && count >= WM_XCB_HINTS_LENGTH)
+    hints.gravity = values[17];
+  return hints;
+}
+
+// Left, right, top, bottom as in _NET_FRAME_EXTENTS; zero when unset
+static gf_frame_extents wm_xcb_extents(xcb_connection_t *conn,
+                                       xcb_get_property_cookie_t cookie) {
+  gf_frame_extents extents = {0};
+  uint32_t values[4];
+
+  if (wm_xcb_cardinal_reply(conn, cookie, values, 4) == 0)
+    extents = (gf_frame_extents){(int)values[0], (int)values[1],
+                                 (int)values[2], (int)values[3]};
+  return extents;
+}
+
+void wm_xcb_fetch_clients(xcb_connection_t *conn, gf_arena *arena,
+                          gf_client_table *table, unsigned long first,
+                          unsigned long count) {
+  if (!conn || count == 0 || first + count > table->count)
+    return;
+
+  wm_xcb_client_cookies *cookies =
+      gf_arena_alloc(arena, sizeof(*cookies) * count);
+  if (!cookies)
+    return;
+
+  // Reparenting WMs report geometry relative to the frame; monitor
+  // assignment needs root coordinates
+  xcb_window_t root = xcb_setup_roots_iterator(xcb_get_setup(conn)).data->root;
+
+  for (unsigned long i = 0; i < count; i++) {
+    xcb_window_t window = (xcb_window_t)table->id[first + i];
+
+    cookies[i].state =
+        xcb_get_property(conn, 0, window, (xcb_atom_t)atoms.net_wm_state,
+                         XCB_ATOM_ATOM, 0, 1024);
+    if (atoms.net_wm_desktop != None)
+      cookies[i].desktop =
+          xcb_get_property(conn, 0, window, (xcb_atom_t)atoms.net_wm_desktop,
+                           XCB_ATOM_CARDINAL, 0, 1);
+    cookies[i].hints =
+        xcb_get_property(conn, 0, window, XCB_ATOM_WM_NORMAL_HINTS,
+                         XCB_ATOM_WM_SIZE_HINTS, 0, WM_XCB_HINTS_LENGTH);
+    cookies[i].frame =
+        wm_xcb_get_property(conn, window, atoms.net_frame_extents,
+                            XCB_ATOM_CARDINAL, 4);
+    cookies[i].shadow =
+        wm_xcb_get_property(conn, window, atoms.gtk_frame_extents,
+                            XCB_ATOM_CARDINAL, 4);
+    cookies[i].protocols = wm_xcb_get_property(conn, window, atoms.wm_protocols,
+                                               XCB_ATOM_ATOM, 32);
+    cookies[i].counter =
+        wm_xcb_get_property(conn, window, atoms.net_wm_sync_request_counter,
+                            XCB_ATOM_CARDINAL, 1);
+    cookies[i].geometry = xcb_get_geometry(conn, window);
+    cookies[i].position = xcb_translate_coordinates(conn, window, root, 0, 0);
+
+    gf_stats_request(GF_REQ_GET_PROPERTY, 0);
+    gf_stats_request(GF_REQ_GET_PROPERTY, 0);
+    if (atoms.net_wm_desktop != None)
+      gf_stats_request(GF_REQ_GET_PROPERTY, 0);
+    gf_stats_request(GF_REQ_GET_GEOMETRY, 0);
+    gf_stats_request(GF_REQ_GET_GEOMETRY, 0);
+  }
+
+  // The whole batch is answered within a single round trip
+  gf_stats_round_trip();
+
+  for (unsigned long i = 0; i < count; i++) {
+    unsigned long index = first + i;
+
+    xcb_get_property_reply_t *state =
+        wm_xcb_property_reply(conn, cookies[i].state);
+    table->flags[index] =
+        (table->flags[index] & ~(GF_CLIENT_EXCLUDED | GF_CLIENT_SYNC)) |
+        wm_xcb_state_flags(state);
+    free(state);
+
+    // Pacing needs both the protocol and a counter to watch
+    uint32_t counter = 0;
+    int sync = wm_xcb_has_atom(conn, cookies[i].protocols,
+                               atoms.net_wm_sync_request);
+    if (wm_xcb_cardinal_reply(conn, cookies[i].counter, &counter, 1) < 0 ||
+        !sync)
+      counter = 0;
+    table->sync[index].counter = counter;
+    if (counter)
+      table->flags[index] |= GF_CLIENT_SYNC;
+
+    long desktop_value = GF_DESKTOP_UNKNOWN;
+    if (atoms.net_wm_desktop != None) {
+      xcb_get_property_reply_t *desktop =
+          wm_xcb_property_reply(conn, cookies[i].desktop);
+      if (desktop) {
+        desktop_value = *(uint32_t *)xcb_get_property_value(desktop);
+        free(desktop);
+      }
+    }
+    gf_client_table_set_desktop(table, index, desktop_value);
+
+    xcb_get_property_reply_t *hints =
+        wm_xcb_property_reply(conn, cookies[i].hints);
+    table->hints[index] = wm_xcb_size_hints(hints);
+    free(hints);
+
+    // Server-side decorations grow the tile, client-side shadows shrink it
+    gf_frame_extents frame = wm_xcb_extents(conn, cookies[i].frame);
+    gf_frame_extents shadow = wm_xcb_extents(conn, cookies[i].shadow);
+    gf_client_table_set_frame(
+        table, index,
+        (gf_frame_extents){frame.left - shadow.left,
+                           frame.right - shadow.right,
+                           frame.top - shadow.top,
+                           frame.bottom - shadow.bottom});
+
+    xcb_generic_error_t *error = NULL;
+    xcb_get_geometry_reply_t *geometry =
+        xcb_get_geometry_reply(conn, cookies[i].geometry, &error);
+    if (geometry) {
+      table->geometry[index] = (gf_rect){geometry->x, geometry->y,
+                                         geometry->width, geometry->height};
+    }
+    free(geometry);
+    free(error);
+
+    error = NULL;
+    xcb_translate_coordinates_reply_t *position =
+        xcb_translate_coordinates_reply(conn, cookies[i].position, &error);
+    if (position) {
+      table->geometry[index].x = position->dst_x;
+      table->geometry[index].y = position->dst_y;
+    }
+    free(position);
+    free(error);
+  }
+}
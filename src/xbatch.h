@@ -0,0 +1,68 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_XBATCH
+#define GF_XBATCH
+
+#include "arena.h"
+#include "client.h"
+#include <X11/Xlib.h>
+#include <xcb/xcb.h>
+
+// Pipelined XCB transport: every helper sends all of its requests before
+// waiting on the first reply, so a batch costs one round trip. Temporary
+// storage comes from the cycle arena and is never freed by the caller.
+
+Window *wm_xcb_get_window_list(xcb_connection_t *conn, gf_arena *arena,
+                               Window window, Atom property,
+                               unsigned long *nitems);
+
+typedef struct {
+  xcb_get_property_cookie_t client_list;
+  xcb_get_property_cookie_t desktop_count;
+  xcb_get_property_cookie_t current_desktop;
+  xcb_get_property_cookie_t workarea;
+} wm_xcb_root_cookies;
+
+typedef struct {
+  Window *clients;
+  unsigned long client_count;
+  unsigned long desktop_count;
+  long current_desktop;
+  gf_rect workarea;
+  int has_workarea;
+} wm_xcb_root_state;
+
+// The root snapshot is split so the caller can wait on something else,
+// such as the RandR monitor query, within the same round trip. Missing
+// properties leave their fields zero, current_desktop -1.
+void wm_xcb_request_root(xcb_connection_t *conn, Window root,
+                         wm_xcb_root_cookies *cookies);
+void wm_xcb_collect_root(xcb_connection_t *conn, gf_arena *arena,
+                         const wm_xcb_root_cookies *cookies,
+                         wm_xcb_root_state *state);
+
+// Refreshes state, desktop, WM_NORMAL_HINTS, frame extents, sync counter
+// and root-relative geometry of rows [first, first + count) in one round
+// trip.
+void wm_xcb_fetch_clients(xcb_connection_t *conn, gf_arena *arena,
+                          gf_client_table *table, unsigned long first,
+                          unsigned long count);
+
+#endif // GF_XBATCH
@@ -0,0 +1,52 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+// Counts the Xlib requests issued by the including file. Include it after
+// every X11 header: each macro shadows the function of the same name and
+// expands to a call of the real one.
+
+#ifndef GF_XSTATS
+#define GF_XSTATS
+
+#include "stats.h"
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#define XGetWindowProperty(...)                                                \
+  (gf_stats_request(GF_REQ_GET_PROPERTY, 1), XGetWindowProperty(__VA_ARGS__))
+#define XGetWMNormalHints(...)                                                 \
+  (gf_stats_request(GF_REQ_GET_PROPERTY, 1), XGetWMNormalHints(__VA_ARGS__))
+#define XSetWMNormalHints(...)                                                 \
+  (gf_stats_request(GF_REQ_CHANGE_PROPERTY, 0), XSetWMNormalHints(__VA_ARGS__))
+#define XChangeProperty(...)                                                   \
+  (gf_stats_request(GF_REQ_CHANGE_PROPERTY, 0), XChangeProperty(__VA_ARGS__))
+#define XGetGeometry(...)                                                      \
+  (gf_stats_request(GF_REQ_GET_GEOMETRY, 1), XGetGeometry(__VA_ARGS__))
+#define XConfigureWindow(...)                                                  \
+  (gf_stats_request(GF_REQ_CONFIGURE, 0), XConfigureWindow(__VA_ARGS__))
+#define XSendEvent(...)                                                        \
+  (gf_stats_request(GF_REQ_SEND_EVENT, 0), XSendEvent(__VA_ARGS__))
+#define XSelectInput(...)                                                      \
+  (gf_stats_request(GF_REQ_SELECT_INPUT, 0), XSelectInput(__VA_ARGS__))
+#define XInternAtom(...)                                                       \
+  (gf_stats_request(GF_REQ_INTERN_ATOM, 1), XInternAtom(__VA_ARGS__))
+#define XFlush(...) (gf_stats_request(GF_REQ_FLUSH, 0), XFlush(__VA_ARGS__))
+#define XSync(...) (gf_stats_request(GF_REQ_SYNC, 1), XSync(__VA_ARGS__))
+
+#endif // GF_XSTATS
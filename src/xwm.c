@@ -18,20 +18,49 @@
  */
 
 #include "xwm.h"
+#include "client.h"
+#include "control.h"
 #include "ewmh.h"
 #include "gridflux.h"
+#include "layout.h"
+#include "pipeline.h"
+#include "planner.h"
+#include "trace.h"
+#include "workspace.h"
+#include "xbatch.h"
+#include <X11/Xlib-xcb.h>
 #include <X11/Xlib.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/sync.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
-#include <sys/types.h>
-#include <sys/wait.h>
 #include <unistd.h>
 
-const int MAX_WIN_OPEN = 8;
+#include "xstats.h"
+
+// The pipeline lives on the planner thread. This thread owns the display
+// and mirrors what it fetched, plus the sync alarms, in its own table.
+static gf_planner planner;
+static gf_client_table clients;
+static gf_arena arena;
+static gf_workspace_backend workspaces;
+static gf_trace trace;
+static gf_control_server control;
+static int commanded; // a control request arrived in this batch
+static unsigned long long start_ns;
+static int tiled;
+static int randr_event_base = -1;
+static int sync_event_base = -1;
+static unsigned long workspace_count;
+static volatile sig_atomic_t running = 1;
 
 static Display *wm_x_initialize_display() {
   int try_index = 0;
@@ -58,34 +87,6 @@ static int wm_x_error_handler(Display *display, XErrorEvent *error) {
   return 0; // Return 0 to prevent the program from terminating
 }
 
-static unsigned char *wm_x_get_window_property(Display *display, Window window,
-                                               Atom property, Atom type,
-                                               unsigned long *nitems,
-                                               int *status_out) {
-  Atom actual_type;
-  int actual_format;
-  unsigned long bytes_after;
-  unsigned char *data = NULL;
-
-  int status = XGetWindowProperty(display, window, property, 0, (~0L), False,
-                                  type, &actual_type, &actual_format, nitems,
-                                  &bytes_after, &data);
-
-  if (status_out)
-    *status_out = status;
-
-  if (status != Success || !data || *nitems == 0) {
-    LOG(GF_ERR, "Failed to fetch property (status=%d, nitems=%lu)", status,
-        *nitems);
-
-    if (data)
-      XFree(data);
-    return NULL;
-  }
-
-  return data;
-}
-
 static int wm_x_send_client_message(Display *display, Window window,
                                     Atom message_type, Atom *atoms,
                                     int atom_count, long *data) {
@@ -111,7 +112,7 @@ static int wm_x_send_client_message(Display *display, Window window,
     return -1;
   }
 
-  XFlush(display);
+  // Flushed together with the rest of the frame before the loop blocks
   return 0;
 }
 
@@ -131,91 +132,65 @@ static int wm_x_move_window_to_workspace(Display *display, Window window,
   return 1;
 }
 
-static void wm_x_get_window_dimension(Display *display, Window window,
-                                      int *width, int *height, int *x, int *y) {
-  XWindowAttributes attributes;
-  int status = XGetWindowAttributes(display, window, &attributes);
-
-  if (status == 0) {
-    LOG(GF_ERR, "Invalid window.\n");
-    return;
-  }
-
-  if (x != NULL)
-    *x = attributes.x;
-  if (y != NULL)
-    *y = attributes.y;
-
-  if (width != NULL)
-    *width = attributes.width;
-
-  if (height != NULL)
-    *height = attributes.height;
+static gf_rect wm_x_pad_rect(gf_rect rect, int pad) {
+  rect.x += pad;
+  rect.y += pad;
+  rect.width = rect.width > pad * 2 ? rect.width - pad * 2 : rect.width;
+  rect.height = rect.height > pad * 2 ? rect.height - pad * 2 : rect.height;
+  return rect;
 }
 
-int wm_x_excluded_window(Display *display, Window window) {
-  Atom actual_type;
-  int actual_format;
-  unsigned long nitems, bytes_after;
-  unsigned char *prop = NULL;
-
-  if (XGetWindowProperty(display, window, atoms.net_wm_state, 0, 1024, False,
-                         XA_ATOM, &actual_type, &actual_format, &nitems,
-                         &bytes_after, &prop) != Success ||
-      prop == NULL) {
-    return 0;
-  }
-
-  Atom *states = (Atom *)prop;
-  int result = 0;
-
-  // Check for excluded window states
-  const Atom excluded_states[] = {
-      atoms.net_wm_hidden,       atoms.net_wm_notification,
-      atoms.net_wm_popup_menu,   atoms.net_wm_tooltip,
-      atoms.net_wm_toolbar,      atoms.net_wm_modal,
-      atoms.net_wm_skip_taskbar, atoms.net_wm_utility};
-
-  const size_t excluded_count =
-      sizeof(excluded_states) / sizeof(excluded_states[0]);
-
-  for (unsigned long i = 0; i < nitems && !result; i++) {
-    for (size_t j = 0; j < excluded_count; j++) {
-      if (states[i] == excluded_states[j]) {
-        result = 1;
-        break;
-      }
-    }
-  }
-
-  XFree(prop);
-  return result;
+// Where the window manager puts the client area for a configured position.
+// ICCCM 4.1.2.3 has it hold the reference point that win_gravity names, so
+// only StaticGravity means the client area itself; the offset is undone
+// here from the cached hints instead of rewriting WM_NORMAL_HINTS.
+static gf_rect wm_x_gravity_position(gf_rect rect, int gravity,
+                                     const gf_frame_extents *frame) {
+  switch (gravity) {
+  case StaticGravity:
+    return rect;
+  case NorthGravity:
+  case CenterGravity:
+  case SouthGravity:
+    rect.x -= (frame->left - frame->right) / 2;
+    break;
+  case NorthEastGravity:
+  case EastGravity:
+  case SouthEastGravity:
+    rect.x += frame->right;
+    break;
+  default: // NorthWestGravity, also when the client sets none
+    rect.x -= frame->left;
+    break;
+  }
+
+  switch (gravity) {
+  case WestGravity:
+  case CenterGravity:
+  case EastGravity:
+    rect.y -= (frame->top - frame->bottom) / 2;
+    break;
+  case SouthWestGravity:
+  case SouthGravity:
+  case SouthEastGravity:
+    rect.y += frame->bottom;
+    break;
+  default:
+    rect.y -= frame->top;
+    break;
+  }
+  return rect;
 }
 
-void wm_x_set_geometry(Display *display, Window window, int gravity,
-                       unsigned long mask, int x, int y, int width,
-                       int height) {
-  XSizeHints hints;
-  long supplied_return;
-
-  if (gravity != 0) {
-    Status status =
-        XGetWMNormalHints(display, window, &hints, &supplied_return);
-    if (status == 0) {
-      memset(&hints, 0, sizeof(hints));
-      hints.flags = 0;
-    }
-
-    hints.flags |= PWinGravity;
-    hints.win_gravity = gravity;
-    XSetWMNormalHints(display, window, &hints);
-  }
-
-  int pad = (mask & APPLY_PADDING) ? DEFAULT_PADDING : 0;
-  x += pad;
-  y += pad;
-  width = width > pad * 2 ? width - pad * 2 : width;
-  height = height > pad * 2 ? height - pad * 2 : height;
+static void wm_x_configure_window(Display *display, Window window,
+                                  unsigned long mask, int x, int y, int width,
+                                  int height) {
+  gf_rect padded = wm_x_pad_rect((gf_rect){x, y, width, height},
+                                 (mask & APPLY_PADDING) ? DEFAULT_PADDING : 0);
+  x = padded.x;
+  y = padded.y;
+  width = padded.width;
+  height = padded.height;
 
   // Remove decorations using _MOTIF_WM_HINTS (optional)
   if (mask & HINT_NO_DECORATIONS) {
@@ -264,111 +239,89 @@ void wm_x_set_geometry(Display *display, Window window, int gravity,
     value_mask |= CWHeight;
 
   XConfigureWindow(display, window, value_mask, &changes);
-  XFlush(display);
 }
 
-static void wm_x_arrange_window(int window_count, Window windows[],
-                                Display *display, int screen) {
-
-  Screen *scr = ScreenOfDisplay(display, screen);
-  int screen_width = scr->width - 5;
-  int screen_height = scr->height;
-
-  void *wins[MAX_WIN_OPEN];
-
-  for (int i = 0; i < window_count; i++)
-    wins[i] = &windows[i];
-
-  gf_split_ctx ctx = {
-      .set_geometry = gf_set_geometry, .user_data = display, .session = GF_X11};
-
-  gf_split_window_generic(wins, window_count, 0, 0, screen_width, screen_height,
-                          0, &ctx);
+void wm_x_set_geometry(Display *display, Window window, unsigned long mask,
+                       int x, int y, int width, int height) {
+  wm_x_configure_window(display, window, mask, x, y, width, height);
+  XFlush(display);
 }
 
-static Bool wm_x_window_in_workspace(Display *display, Window window,
-                                     int workspace_id) {
-  if (atoms.net_wm_desktop == None)
-    return False;
-
-  unsigned long nitems = 0;
-  int status;
-
-  unsigned char *data = wm_x_get_window_property(
-      display, window, atoms.net_wm_desktop, XA_CARDINAL, &nitems, &status);
+static void wm_x_post_client(unsigned long index) {
+  gf_planner_post(&planner, &(gf_trace_record){
+                                .type = GF_TRACE_CLIENT,
+                                .window = clients.id[index],
+                                .value = clients.desktop[index],
+                                .flags = clients.flags[index] &
+                                         GF_CLIENT_FETCHED,
+                                .rect = clients.geometry[index],
+                                .hints = clients.hints[index],
+                                .frame = clients.frame[index],
+                            });
+}
 
-  if (!data || status != Success || nitems < 1)
-    return False;
+static void wm_x_refresh_client(Display *display, unsigned long index) {
+  gf_stats_scope scope = gf_stats_begin(GF_STAGE_FETCH);
 
-  unsigned long window_workspace_id = *(unsigned long *)data;
-  XFree(data);
+  wm_xcb_fetch_clients(XGetXCBConnection(display), &arena, &clients, index,
+                       1);
+  wm_x_post_client(index);
 
-  return window_workspace_id == (unsigned long)workspace_id;
+  gf_stats_end(&scope);
 }
 
-static Window *wm_x_filter_windows(Display *display, Window *windows,
-                                   unsigned long *nitems, int workspace_id) {
-  if (!windows || !nitems || *nitems == 0)
-    return NULL;
+// Atoms resolved late can change what every known client reports
+static void wm_x_refresh_all_clients(Display *display) {
+  gf_stats_scope scope = gf_stats_begin(GF_STAGE_FETCH);
 
-  Window *filtered = malloc(sizeof(Window) * (*nitems));
-  if (!filtered) {
-    LOG(GF_ERR, ERR_FAIL_ALLOCATE);
-    return NULL;
-  }
-
-  unsigned long count = 0;
-  for (unsigned long i = 0; i < *nitems; ++i) {
-    Window window = windows[i];
-    if (wm_x_excluded_window(display, window))
-      continue;
+  wm_xcb_fetch_clients(XGetXCBConnection(display), &arena, &clients, 0,
+                       clients.count);
+  for (unsigned long i = 0; i < clients.count; i++)
+    wm_x_post_client(i);
 
-    if (wm_x_window_in_workspace(display, window, workspace_id)) {
-      filtered[count++] = window;
-    }
-  }
+  gf_stats_end(&scope);
+}
 
-  *nitems = count;
-  return filtered;
+static void wm_x_forget(void *user_data, gf_client_table *table,
+                        unsigned long index) {
+  if (table->sync[index].alarm)
+    XSyncDestroyAlarm((Display *)user_data, table->sync[index].alarm);
 }
 
-static Window *wm_x_get_window_property_list(Display *display, Window root,
-                                             Atom atom, unsigned long *nitems) {
-  if (!display || !nitems)
-    return NULL;
+static void wm_x_apply_client_list(Display *display, const Window *windows,
+                                   unsigned long nitems) {
+  xcb_connection_t *conn = XGetXCBConnection(display);
+  unsigned long first =
+      gf_client_table_sync(&clients, windows, nitems, wm_x_forget, display);
 
-  int status;
-  unsigned char *data =
-      wm_x_get_window_property(display, root, atom, XA_WINDOW, nitems, &status);
+  gf_planner_post(&planner, &(gf_trace_record){.type = GF_TRACE_CLIENT_LIST,
+                                               .windows = (Window *)windows,
+                                               .count = nitems});
 
-  if (status != Success || !data || *nitems == 0) {
-    if (data)
-      XFree(data);
-    return NULL;
-  }
+  // Select before reading so a change in between still reaches us
+  for (unsigned long i = first; i < clients.count; i++)
+    XSelectInput(display, clients.id[i],
+                 StructureNotifyMask | PropertyChangeMask);
 
-  return (Window *)data;
+  wm_xcb_fetch_clients(conn, &arena, &clients, first, clients.count - first);
+  for (unsigned long i = first; i < clients.count; i++)
+    wm_x_post_client(i);
 }
 
-static Window *wm_x_fetch_window_list(Display *display, Window root,
-                                      unsigned long *nitems, Atom atom,
-                                      int workspace_id) {
-  if (!display || !nitems)
-    return NULL;
-
-  Window *windows = wm_x_get_window_property_list(display, root, atom, nitems);
-  if (!windows || *nitems == 0)
-    return NULL;
-
-  Window *filtered =
-      wm_x_filter_windows(display, windows, nitems, workspace_id);
-  XFree(windows);
+static void wm_x_sync_client_list(Display *display, Window root) {
+  gf_stats_scope scope = gf_stats_begin(GF_STAGE_FETCH);
+  unsigned long nitems = 0;
+  Window *windows =
+      wm_xcb_get_window_list(XGetXCBConnection(display), &arena, root,
+                             atoms.client_list, &nitems);
 
-  return filtered;
+  wm_x_apply_client_list(display, windows, nitems);
+  gf_stats_end(&scope);
 }
 
-static unsigned long int wm_x_get_current_workspace(Display *display,
-                                                    Window root) {
+// Returns -1 when the root window has no usable _NET_CURRENT_DESKTOP; the
+// display stays open so the caller can simply skip this update.
+static long wm_x_get_current_workspace(Display *display, Window root) {
   unsigned long *desktop = NULL;
   Atom actualType;
   int actualFormat;
@@ -377,36 +330,16 @@ static unsigned long int wm_x_get_current_workspace(Display *display,
   if (XGetWindowProperty(display, root, atoms.net_curr_desktop, 0, 1, False,
                          XA_CARDINAL, &actualType, &actualFormat, &nItems,
                          &bytesAfter, (unsigned char **)&desktop) == Success &&
-      desktop) {
-    int workspaceNumber = (int)*desktop;
+      desktop && nItems > 0) {
+    long workspaceNumber = (long)*desktop;
     XFree(desktop);
     return workspaceNumber;
-  } else {
-    LOG(GF_ERR, ERR_BAD_WINDOW);
-    XCloseDisplay(display);
-    return -1;
   }
-}
-
-static Window wm_x_get_last_opened_window(Display *display) {
-  Atom actual_type;
-  int actual_format;
-  unsigned long nitems, bytes_after;
-  unsigned char *data = NULL;
 
-  if (XGetWindowProperty(display, DefaultRootWindow(display),
-                         atoms.client_list_stack, 0, (~0L), False, XA_WINDOW,
-                         &actual_type, &actual_format, &nitems, &bytes_after,
-                         &data) == Success &&
-      data) {
-    Window *stacking_list = (Window *)data;
-    Window last_window =
-        stacking_list[nitems - 1]; // The last window in the list
-    XFree(data);
-    return last_window;
-  }
-
-  return 0;
+  if (desktop)
+    XFree(desktop);
+  LOG(GF_ERR, ERR_BAD_WINDOW);
+  return -1;
 }
 
 static unsigned long wm_x_get_total_workspace(Display *display, Window root) {
@@ -432,248 +365,528 @@ static unsigned long wm_x_get_total_workspace(Display *display, Window root) {
   return total_workspaces;
 }
 
-static int wm_x_get_total_window(Display *display, Window root) {
-  unsigned long total_win = 0;
-  int total_workspaces = wm_x_get_total_workspace(display, root);
+// Hacky
+const char *wm_x_detect_desktop_environment() {
+  const char *xdg_current_desktop = getenv("XDG_CURRENT_DESKTOP");
+  const char *desktop_session = getenv("DESKTOP_SESSION");
+  const char *kde_full_session = getenv("KDE_FULL_SESSION");
+  const char *gnome_session_id = getenv("GNOME_DESKTOP_SESSION_ID");
 
-  for (int i = 0; i <= total_workspaces; i++) {
-    unsigned long current_window_count = 0;
-    Window *winlist = wm_x_fetch_window_list(
-        display, root, &current_window_count, atoms.client_list, i);
-    if (!winlist)
-      continue;
+  if (kde_full_session && strcmp(kde_full_session, "true") == 0) {
+    return "KDE";
+  } else if (gnome_session_id ||
+             (xdg_current_desktop && strstr(xdg_current_desktop, "GNOME"))) {
+    return "GNOME";
+  } else if (xdg_current_desktop) {
+    return xdg_current_desktop; // Return the value of XDG_CURRENT_DESKTOP
+  } else if (desktop_session) {
+    return desktop_session; // Return the value of DESKTOP_SESSION
+  } else {
+    return "Unknown";
   }
+}
+
+static int wm_x_ewmh_request_workspace(void *user_data, unsigned long current,
+                                       unsigned long wanted) {
+  Display *display = (Display *)user_data;
+  long data[] = {(long)wanted};
 
-  return total_win;
+  return wm_x_send_client_message(display, DefaultRootWindow(display),
+                                  atoms.num_of_desktop, NULL, 1, data);
 }
 
-static void wm_x_arrange_dimension(Display *display, Window root,
-                                   unsigned long base_win_items,
-                                   Window *curr_win_open,
-                                   gf_win_info *base_gf_win_info, int screen) {
-  for (unsigned long int i = 0; i < base_win_items; i++) {
-    gf_win_info *curr_gf_win_info =
-        (gf_win_info *)malloc(base_win_items * sizeof(gf_win_info));
-    wm_x_get_window_dimension(display, curr_win_open[i],
-                              &curr_gf_win_info[i].width,
-                              &curr_gf_win_info[i].height, NULL, NULL);
+// Asks the client to bump its XSync counter once it has painted the next
+// configure, and arms an alarm that reports when it did.
+static void wm_x_request_sync(Display *display, unsigned long index) {
+  gf_client_sync *sync = &clients.sync[index];
+  Window window = clients.id[index];
+
+  // Values follow the monotonic clock, so they stay ahead of any the real
+  // WM sent for its own resizes and never repeat for one window
+  unsigned long long value = gf_stats_now_ns() / 1000;
+  XSyncAlarmAttributes attributes;
+  XSyncIntsToValue(&attributes.trigger.wait_value,
+                   (unsigned int)(value & 0xffffffff), (int)(value >> 32));
+  XSyncIntToValue(&attributes.delta, 0);
+  attributes.trigger.counter = sync->counter;
+  attributes.trigger.value_type = XSyncAbsolute;
+  attributes.trigger.test_type = XSyncPositiveComparison;
+  attributes.events = True;
+
+  // A zero delta leaves the alarm inactive once it fired, until the next
+  unsigned long mask = XSyncCACounter | XSyncCAValueType | XSyncCAValue |
+                       XSyncCATestType | XSyncCADelta | XSyncCAEvents;
+  if (sync->alarm)
+    XSyncChangeAlarm(display, sync->alarm, mask, &attributes);
+  else
+    sync->alarm = XSyncCreateAlarm(display, mask, &attributes);
 
-    if (curr_gf_win_info[i].width != base_gf_win_info[i].width ||
-        curr_gf_win_info[i].height != base_gf_win_info[i].height) {
-      wm_x_unmaximize_window(display, curr_win_open[i]);
-      wm_x_arrange_window(base_win_items, curr_win_open, display, screen);
+  XClientMessageEvent event = {0};
+  event.type = ClientMessage;
+  event.window = window;
+  event.message_type = atoms.wm_protocols;
+  event.format = 32;
+  event.data.l[0] = atoms.net_wm_sync_request;
+  event.data.l[1] = CurrentTime;
+  event.data.l[2] = (long)(value & 0xffffffff);
+  event.data.l[3] = (long)(value >> 32);
+  XSendEvent(display, window, False, NoEventMask, (XEvent *)&event);
+}
 
-      base_gf_win_info[i].width = curr_gf_win_info[i].width;
-      base_gf_win_info[i].height = curr_gf_win_info[i].height;
-    }
+static void wm_x_apply_action(Display *display, const gf_action *action) {
+  if (action->type == GF_ACTION_WORKSPACES) {
+    if (workspaces.request &&
+        workspaces.request(workspaces.user_data, action->current,
+                           (unsigned long)action->value) < 0)
+      LOG(GF_WARN, "Requesting %ld workspaces from %s failed", action->value,
+          workspaces.name);
+    return;
+  }
 
-    free(curr_gf_win_info);
-  }
-}
-
-static void wm_x_distribute_overflow_window(
-    Display *display, int *overflow_workspace, int overflow_workspace_total,
-    gf_workspace_info *free_workspace, int free_workspace_total,
-    Atom window_list_atom, Window root, int screen) {
-  for (int i = 0; i < overflow_workspace_total; i++) {
-    unsigned long current_window_count = 0;
-    Window *active_windows =
-        wm_x_fetch_window_list(display, root, &current_window_count,
-                               window_list_atom, overflow_workspace[i]);
-
-    for (int j = 0; j <= free_workspace_total; j++) {
-      for (int x = 0; x <= free_workspace[j].available_space; x++) {
-        if (current_window_count >= MAX_WIN_OPEN) {
-          wm_x_unmaximize_window(display,
-                                 active_windows[current_window_count--]);
-          wm_x_move_window_to_workspace(display,
-                                        active_windows[current_window_count--],
-                                        free_workspace[j].workspace_id);
-          free_workspace[j].available_space--;
-        }
-      }
-    }
+  if (action->type == GF_ACTION_REPLY) {
+    gf_control_reply_to(&control, action->window, &action->reply);
+    return;
+  }
 
-    if (active_windows) {
-      wm_x_arrange_window(current_window_count, active_windows, display,
-                          screen);
+  if (action->type == GF_ACTION_DONE) {
+    if (!tiled) {
+      XFlush(display);
+      gf_stats_first_tile(gf_stats_now_ns() - start_ns);
+      tiled = 1;
     }
+    return;
+  }
+
+  // The planner lags behind this table, never ahead of it: a window it
+  // no longer holds is gone from the server as well
+  long index = gf_client_table_find(&clients, action->window);
+  if (index < 0)
+    return;
+
+  switch (action->type) {
+  case GF_ACTION_UNMAXIMIZE:
+    wm_x_unmaximize_window(display, action->window);
+    break;
+  case GF_ACTION_MOVE:
+    wm_x_move_window_to_workspace(display, action->window, (int)action->value);
+    break;
+  case GF_ACTION_CONFIGURE: {
+    // The request goes first so the client counts this configure towards it
+    if ((action->flags & GF_CLIENT_SYNCING) && clients.sync[index].counter)
+      wm_x_request_sync(display, (unsigned long)index);
+
+    gf_rect rect = wm_x_gravity_position(
+        action->rect, clients.hints[index].gravity, &clients.frame[index]);
+    wm_x_configure_window(display, action->window,
+                          CHANGE_X | CHANGE_Y | CHANGE_WIDTH | CHANGE_HEIGHT,
+                          rect.x, rect.y, rect.width, rect.height);
+    break;
+  }
+  default:
+    break;
   }
 }
 
-static void wm_x_handle_window_overflow(Display *display, Window root,
-                                        unsigned long *current_window_count,
-                                        Atom window_list_atom,
-                                        int total_workspace, int screen) {
-  int overflow_workspace[total_workspace];
-  int overflow_workspace_total = 0;
+static void wm_x_apply_actions(Display *display) {
+  gf_stats_scope scope = gf_stats_begin(GF_STAGE_APPLY);
+  gf_action action;
 
-  gf_workspace_info free_workspace[total_workspace];
-  int free_workspace_total = 0;
+  gf_spsc_clear(&planner.actions);
+  while (gf_spsc_pop(&planner.actions, &action))
+    wm_x_apply_action(display, &action);
 
-  for (int workspace = 0; workspace <= total_workspace; workspace++) {
-    Window *active_windows = wm_x_fetch_window_list(
-        display, root, current_window_count, window_list_atom, workspace);
+  gf_stats_end(&scope);
+}
 
-    if (*current_window_count >= MAX_WIN_OPEN) {
-      overflow_workspace[overflow_workspace_total] = workspace;
-      overflow_workspace_total++;
-    } else if (*current_window_count + 1 < MAX_WIN_OPEN) {
-      int available_space = MAX_WIN_OPEN - *current_window_count;
-      free_workspace[free_workspace_total].workspace_id = workspace;
-      free_workspace[free_workspace_total].total_window_open =
-          *current_window_count;
-      free_workspace[free_workspace_total].available_space = available_space;
-      free_workspace_total++;
-    }
+static int wm_x_init_planner(Display *display, int screen) {
+  workspaces = (gf_workspace_backend){.name = "ewmh",
+                                      .request = wm_x_ewmh_request_workspace,
+                                      .user_data = display};
+
+  if (strcmp(wm_x_detect_desktop_environment(), "KDE") == 0)
+    gf_kwin_backend_init(&workspaces);
+
+  Screen *scr = ScreenOfDisplay(display, screen);
+  gf_rect area = {0, 0, scr->width, scr->height};
+
+  if (gf_client_table_init(&clients, 0) < 0)
+    return -1;
+  if (gf_planner_init(&planner, workspaces.name, area,
+                      getenv("GRIDFLUX_LAYOUTS")) < 0) {
+    gf_client_table_free(&clients);
+    return -1;
   }
-  wm_x_distribute_overflow_window(
-      display, overflow_workspace, overflow_workspace_total, free_workspace,
-      free_workspace_total, window_list_atom, root, screen);
+
+  gf_pipeline *pipeline = &planner.pipeline;
+  pipeline->max_windows =
+      gf_pipeline_parse_max_windows(getenv("GRIDFLUX_MAX_WINDOWS"));
+  pipeline->sync_timeout_ns =
+      gf_pipeline_parse_sync_timeout(getenv("GRIDFLUX_SYNC_TIMEOUT_MS"));
+
+  int error_base, major, minor;
+  if (pipeline->sync_timeout_ns &&
+      (!XSyncQueryExtension(display, &sync_event_base, &error_base) ||
+       !XSyncInitialize(display, &major, &minor))) {
+    LOG(GF_WARN, "No XSync extension, configures are not paced");
+    pipeline->sync_timeout_ns = 0;
+  }
+  if (!pipeline->sync_timeout_ns)
+    sync_event_base = -1;
+  return 0;
 }
 
-static void wm_x_manage_workspace_window(Display *display, Window root,
-                                         unsigned long *previous_window_count,
-                                         int total_workspace, int screen) {
-  unsigned long current_window_count = 0;
-  Window *active_windows;
+static void wm_x_start_trace(const char *path) {
+  gf_trace_header header = {.area = planner.pipeline.outputs[0],
+                            .max_windows = planner.pipeline.max_windows};
+  const char *layouts = getenv("GRIDFLUX_LAYOUTS");
+  if (layouts)
+    snprintf(header.layouts, sizeof(header.layouts), "%s", layouts);
 
-  for (int workspace = 0; workspace < total_workspace; workspace++) {
-    active_windows = wm_x_fetch_window_list(
-        display, root, &current_window_count, atoms.client_list, workspace);
-    if (!active_windows) {
-      continue;
-    }
+  if (gf_trace_open_write(&trace, path, &header) == 0) {
+    LOG(GF_INFO, "Recording trace to %s", path);
+    planner.pipeline.trace = &trace;
+  }
+}
 
-    if (current_window_count > MAX_WIN_OPEN) {
-      wm_x_handle_window_overflow(display, root, &current_window_count,
-                                  atoms.client_list, total_workspace, screen);
-    }
+static int wm_x_get_workarea(Display *display, Window root, gf_rect *area) {
+  Atom actual_type;
+  int actual_format;
+  unsigned long nitems, bytes_after;
+  unsigned char *data = NULL;
+
+  if (atoms.net_workarea == None ||
+      XGetWindowProperty(display, root, atoms.net_workarea, 0, 4, False,
+                         XA_CARDINAL, &actual_type, &actual_format, &nitems,
+                         &bytes_after, &data) != Success ||
+      !data || nitems < 4) {
+    if (data)
+      XFree(data);
+    return -1;
   }
+
+  // Per desktop, but desktops share the same struts in practice
+  long *values = (long *)data;
+  *area = (gf_rect){values[0], values[1], values[2], values[3]};
+  XFree(data);
+  return 0;
 }
 
-static void
-wm_x_rearrange_current_workspace(Display *display, Window root,
-                                 unsigned long *previous_window_count,
-                                 int screen, gf_win_info *window_properties) {
-  unsigned long current_window_count = 0;
-  int current_workspace = wm_x_get_current_workspace(display, root);
-  Window *active_windows =
-      wm_x_fetch_window_list(display, root, &current_window_count,
-                             atoms.client_list, current_workspace);
+static gf_rect wm_x_intersect(gf_rect a, gf_rect b) {
+  int left = a.x > b.x ? a.x : b.x;
+  int top = a.y > b.y ? a.y : b.y;
+  int right = a.x + a.width < b.x + b.width ? a.x + a.width : b.x + b.width;
+  int bottom =
+      a.y + a.height < b.y + b.height ? a.y + a.height : b.y + b.height;
 
-  if (current_window_count != *previous_window_count) {
-    *previous_window_count = current_window_count;
+  if (right <= left || bottom <= top)
+    return a;
+  return (gf_rect){left, top, right - left, bottom - top};
+}
 
-    for (unsigned long i = 0; i <= current_window_count; i++) {
-      if (active_windows[i]) {
-        wm_x_unmaximize_window(display, active_windows[i]);
-      }
-    }
+static int wm_x_query_monitors(Display *display, Window root, int screen,
+                               gf_rect *areas) {
+  int count = 0;
 
-    if (active_windows) {
-      wm_x_arrange_window(current_window_count, active_windows, display,
-                          screen);
-    }
-  }
+  if (randr_event_base >= 0) {
+    int monitor_count = 0;
+    XRRMonitorInfo *monitors =
+        XRRGetMonitors(display, root, True, &monitor_count);
 
-  wm_x_arrange_dimension(display, root, current_window_count, active_windows,
-                         window_properties, screen);
+    for (int i = 0; i < monitor_count && count < GF_LAYOUT_MAX_OUTPUTS; i++)
+      areas[count++] = (gf_rect){monitors[i].x, monitors[i].y,
+                                 monitors[i].width, monitors[i].height};
+    if (monitors)
+      XRRFreeMonitors(monitors);
+  }
 
-  if (active_windows) {
-    XFree(active_windows);
+  if (count == 0) {
+    Screen *scr = ScreenOfDisplay(display, screen);
+    areas[count++] = (gf_rect){0, 0, scr->width, scr->height};
   }
+  return count;
 }
 
-// Hacky
-const char *wm_x_detect_desktop_environment() {
-  const char *xdg_current_desktop = getenv("XDG_CURRENT_DESKTOP");
-  const char *desktop_session = getenv("DESKTOP_SESSION");
-  const char *kde_full_session = getenv("KDE_FULL_SESSION");
-  const char *gnome_session_id = getenv("GNOME_DESKTOP_SESSION_ID");
-
-  if (kde_full_session && strcmp(kde_full_session, "true") == 0) {
-    return "KDE";
-  } else if (gnome_session_id ||
-             (xdg_current_desktop && strstr(xdg_current_desktop, "GNOME"))) {
-    return "GNOME";
-  } else if (xdg_current_desktop) {
-    return xdg_current_desktop; // Return the value of XDG_CURRENT_DESKTOP
-  } else if (desktop_session) {
-    return desktop_session; // Return the value of DESKTOP_SESSION
-  } else {
-    return "Unknown";
+static void wm_x_set_outputs(gf_rect *areas, int count,
+                             const gf_rect *workarea) {
+  // Docks and panels reserve their struts through the work area
+  if (workarea) {
+    for (int i = 0; i < count; i++)
+      areas[i] = wm_x_intersect(areas[i], *workarea);
   }
+
+  gf_planner_post(&planner, &(gf_trace_record){.type = GF_TRACE_OUTPUTS,
+                                               .rects = areas,
+                                               .count = count});
 }
 
-static void wm_x_create_new_workspace(Display *display, Window root,
-                                      unsigned long new_workspace) {
+static void wm_x_update_outputs(Display *display, Window root, int screen) {
+  gf_rect areas[GF_LAYOUT_MAX_OUTPUTS];
+  gf_rect workarea;
+  int count = wm_x_query_monitors(display, root, screen, areas);
+  int has_workarea = wm_x_get_workarea(display, root, &workarea) == 0;
 
-  XChangeProperty(display, root, atoms.net_curr_desktop, XA_CARDINAL, 32,
-                  PropModeReplace, (unsigned char *)&new_workspace, 1);
-  XSync(display, False); // Ensure the action is committed
+  wm_x_set_outputs(areas, count, has_workarea ? &workarea : NULL);
 }
 
-// Hacky
-static void wm_x_set_workspace(Display *display, Window root,
-                               unsigned long workspace) {
-  const char *desktop_session = wm_x_detect_desktop_environment();
-  if (desktop_session == NULL || strcmp(desktop_session, "Unknown") == 0) {
-    LOG(GF_DBG, "No desktop session detected. Exiting.\n");
+// Everything the first pass needs is requested up front and waited on
+// together: the root properties, the monitors, then the client states.
+static void wm_x_load_snapshot(Display *display, Window root, int screen) {
+  gf_stats_scope scope = gf_stats_begin(GF_STAGE_FETCH);
+  xcb_connection_t *conn = XGetXCBConnection(display);
+  wm_xcb_root_cookies cookies;
+  wm_xcb_root_state state;
+  gf_rect areas[GF_LAYOUT_MAX_OUTPUTS];
+  int error_base;
+
+  if (XRRQueryExtension(display, &randr_event_base, &error_base))
+    XRRSelectInput(display, root, RRScreenChangeNotifyMask);
+  else
+    randr_event_base = -1;
+
+  wm_xcb_request_root(conn, root, &cookies);
+  int count = wm_x_query_monitors(display, root, screen, areas);
+  wm_xcb_collect_root(conn, &arena, &cookies, &state);
+
+  wm_x_set_outputs(areas, count, state.has_workarea ? &state.workarea : NULL);
+  workspace_count = state.desktop_count;
+  wm_x_apply_client_list(display, state.clients, state.client_count);
+
+  gf_stats_end(&scope);
+}
+
+static void wm_x_sync_alarm(Display *display, XSyncAlarmNotifyEvent *event) {
+  // Only clients we are waiting for have an armed alarm, so this is rare
+  for (unsigned long i = 0; i < clients.count; i++) {
+    if (clients.sync[i].alarm != event->alarm)
+      continue;
+
+    // The client dropped its counter; the alarm is of no further use
+    if (event->state == XSyncAlarmDestroyed) {
+      XSyncDestroyAlarm(display, event->alarm);
+      clients.sync[i].alarm = None;
+    }
+    gf_planner_post(&planner, &(gf_trace_record){.type = GF_TRACE_SYNC,
+                                                 .window = clients.id[i]});
     return;
   }
+}
 
-  pid_t pid = fork();
+static void wm_x_handle_event(Display *display, Window root, int screen,
+                              XEvent *event) {
+  long index;
 
-  if (pid == -1) {
-    perror("Failed to fork");
+  if (sync_event_base >= 0 &&
+      event->type == sync_event_base + XSyncAlarmNotify) {
+    wm_x_sync_alarm(display, (XSyncAlarmNotifyEvent *)event);
     return;
   }
 
-  if (pid == 0) {
-    if (strcmp(desktop_session, "KDE") == 0) {
-      if (execlp("qdbus", "qdbus", "org.kde.KWin", "/VirtualDesktopManager",
-                 "createDesktop", "1", "LittleWin", NULL) == -1) {
-        perror("Error executing qdbus");
-        _exit(EXIT_FAILURE);
-      }
-    } else if (strcmp(desktop_session, "GNOME") == 0) {
-      if (execlp("gsettings", "gsettings", "set", "org.gnome.mutter",
-                 "dynamic-workspaces", "true", NULL) == -1) {
-        perror("Error executing gsettings");
-        _exit(EXIT_FAILURE);
-      }
-      wm_x_create_new_workspace(display, root, workspace);
-    } else {
-      int status;
-      waitpid(pid, &status, 0);
-      if (WIFEXITED(status)) {
-        LOG(GF_DBG, "command exited with status %d\n", WEXITSTATUS(status));
-      } else {
-        perror("command did not terminate normally\n");
-        _exit(EXIT_FAILURE);
+  if (randr_event_base >= 0 &&
+      event->type == randr_event_base + RRScreenChangeNotify) {
+    XRRUpdateConfiguration(event);
+    wm_x_update_outputs(display, root, screen);
+    return;
+  }
+
+  switch (event->type) {
+  case PropertyNotify: {
+    Atom atom = event->xproperty.atom;
+    if (gf_atom_seen(display, atom) > 0) {
+      wm_x_sync_client_list(display, root);
+      wm_x_refresh_all_clients(display);
+    }
+
+    if (event->xproperty.window == root) {
+      if (atom == atoms.client_list)
+        wm_x_sync_client_list(display, root);
+      else if (atom == atoms.net_curr_desktop) {
+        long workspace = wm_x_get_current_workspace(display, root);
+        if (workspace >= 0)
+          gf_planner_post(&planner,
+                          &(gf_trace_record){.type = GF_TRACE_MARK,
+                                             .value = workspace});
+      } else if (atom == atoms.num_of_desktop) {
+        workspace_count = wm_x_get_total_workspace(display, root);
+        gf_planner_post(&planner,
+                        &(gf_trace_record){.type = GF_TRACE_MARK_ALL,
+                                           .value = (long)workspace_count});
       }
+      else if (atom == atoms.net_workarea)
+        wm_x_update_outputs(display, root, screen);
+      return;
     }
+
+    index = gf_client_table_find(&clients, event->xproperty.window);
+    if (index < 0)
+      return;
+
+    if (atom == atoms.net_wm_desktop || atom == atoms.net_wm_state ||
+        atom == XA_WM_NORMAL_HINTS || atom == atoms.net_frame_extents ||
+        atom == atoms.gtk_frame_extents || atom == atoms.wm_protocols ||
+        atom == atoms.net_wm_sync_request_counter)
+      wm_x_refresh_client(display, index);
+    return;
   }
-}
+  case ConfigureNotify: {
+    // Root substructure reports frames; only the client's own notify counts
+    XConfigureEvent *configure = &event->xconfigure;
+    if (configure->event == root)
+      return;
 
-static void wm_x_manage_window(Display *display, Window root,
-                               unsigned long *previous_window_count,
-                               gf_win_info *window_properties, int screen) {
-  if (!display) {
-    LOG(GF_WARN, ERR_DISPLAY_NULL);
+    // Only synthetic notifies carry root coordinates, real ones are
+    // relative to the frame and keep the last known position
+    gf_rect geometry = {configure->x, configure->y, configure->width,
+                        configure->height};
+    index = gf_client_table_find(&clients, configure->window);
+    if (index >= 0 && !configure->send_event) {
+      geometry.x = clients.geometry[index].x;
+      geometry.y = clients.geometry[index].y;
+    }
+    if (index >= 0)
+      clients.geometry[index] = geometry;
+
+    gf_planner_post(&planner, &(gf_trace_record){.type = GF_TRACE_CONFIGURE,
+                                                 .window = configure->window,
+                                                 .rect = geometry});
+    return;
+  }
+  case DestroyNotify:
+    if (event->xdestroywindow.event == root)
+      return;
+
+    index = gf_client_table_find(&clients, event->xdestroywindow.window);
+    if (index < 0)
+      return;
+
+    wm_x_forget(display, &clients, (unsigned long)index);
+    gf_client_table_remove(&clients, (unsigned long)index);
+    gf_planner_post(&planner,
+                    &(gf_trace_record){.type = GF_TRACE_DESTROY,
+                                       .window = event->xdestroywindow.window});
+    return;
+  default:
     return;
   }
+}
+
+static void wm_x_stop(int signal) {
+  (void)signal;
+  running = 0;
+}
 
-  unsigned long total_workspace = wm_x_get_total_workspace(display, root);
+// Runs between event batches, so a command is ordered with the X inputs
+// instead of racing them; what changes the layout goes to the planner.
+static int wm_x_control(void *user_data, unsigned long requester,
+                        const gf_control_request *request) {
+  Display *display = user_data;
+  gf_control_reply reply = {.status = GF_CONTROL_OK};
+  gf_trace_record record = {0};
+  long index;
+
+  // Only workspaces that exist; anything else would size tables after it
+  int workspace_known = request->workspace >= 0 &&
+                        (unsigned long)request->workspace < workspace_count;
+
+  switch (request->command) {
+  case GF_CONTROL_RELAYOUT:
+    if (request->workspace >= 0 && !workspace_known) {
+      reply.status = GF_CONTROL_BAD_REQUEST;
+      break;
+    }
+    record = (gf_trace_record){.type = GF_TRACE_RELAYOUT,
+                               .value = request->workspace < 0
+                                            ? -1
+                                            : request->workspace};
+    break;
+  case GF_CONTROL_LAYOUT:
+    if (!workspace_known || request->argument < 0 ||
+        request->argument >= GF_LAYOUT_KIND_COUNT) {
+      reply.status = GF_CONTROL_BAD_REQUEST;
+      break;
+    }
+    record = (gf_trace_record){.type = GF_TRACE_LAYOUT,
+                               .value = request->workspace,
+                               .flags = (unsigned int)request->argument};
+    break;
+  case GF_CONTROL_MOVE:
+    index = gf_client_table_find(&clients, (Window)request->window);
+    if (!workspace_known)
+      reply.status = GF_CONTROL_BAD_REQUEST;
+    else if (index < 0)
+      reply.status = GF_CONTROL_UNKNOWN_WINDOW;
+    else
+      // The desktop change comes back as an event like any other move
+      wm_x_move_window_to_workspace(display, (Window)request->window,
+                                    request->workspace);
+    break;
+  case GF_CONTROL_CAPACITY:
+    if (request->argument < 0 || request->argument > INT_MAX) {
+      reply.status = GF_CONTROL_BAD_REQUEST;
+      break;
+    }
+    record = (gf_trace_record){.type = GF_TRACE_CAPACITY,
+                               .value = (long)request->argument};
+    break;
+  case GF_CONTROL_PAUSE:
+  case GF_CONTROL_RESUME:
+    record = (gf_trace_record){.type = GF_TRACE_PAUSE,
+                               .value = request->command == GF_CONTROL_PAUSE};
+    break;
+  case GF_CONTROL_QUERY:
+    // Answered by the planner once it has applied everything before it
+    gf_planner_post(&planner,
+                    &(gf_trace_record){.type = GF_PLANNER_QUERY,
+                                       .window = requester,
+                                       .value = request->workspace});
+    return 1;
+  default:
+    reply.status = GF_CONTROL_BAD_REQUEST;
+    break;
+  }
+
+  if (record.type)
+    gf_planner_post(&planner, &record);
+  commanded = 1;
+  gf_control_reply_to(&control, requester, &reply);
+  return 0;
+}
 
-  wm_x_manage_workspace_window(display, root, previous_window_count,
-                               total_workspace, screen);
-  wm_x_rearrange_current_workspace(display, root, previous_window_count, screen,
-                                   window_properties);
+// Ends an event batch: the planner lays out once for all of it
+static void wm_x_post_pass(void) {
+  gf_planner_post(&planner, &(gf_trace_record){.type = GF_TRACE_PASS,
+                                               .value = (long)workspace_count});
 }
 
-void wm_x_run_layout() {
+// Fills `fds` with the X connection, the planner's actions and the control
+// sockets, and returns how many; the control ones report what is ready.
+static int wm_x_wait_for_events(Display *display, struct pollfd *fds) {
+  fds[0] = (struct pollfd){.fd = ConnectionNumber(display), .events = POLLIN};
+  fds[1] = (struct pollfd){.fd = gf_spsc_fd(&planner.actions),
+                           .events = POLLIN};
+  int count = 2 + gf_control_poll_fds(&control, fds + 2);
+
+  XFlush(display);
+  if (XPending(display))
+    return count;
+
+  // Inputs that found the queue full are retried shortly
+  int timeout_ms = gf_planner_flush(&planner) ? 1 : -1;
+
+  // A signal interrupts the wait so the caller can act on it
+  if (poll(fds, count, timeout_ms) < 0) {
+    if (errno != EINTR) {
+      LOG(GF_ERR, "poll on X connection failed: %s", strerror(errno));
+      return -1;
+    }
+    for (int i = 0; i < count; i++)
+      fds[i].revents = 0;
+  }
+
+  return count;
+}
+
+void wm_x_run_layout(const char *trace_path) {
+  start_ns = gf_stats_now_ns();
   Display *display = wm_x_initialize_display();
   if (!display) {
     LOG(GF_ERR, ERR_DISPLAY_NULL);
@@ -685,50 +898,80 @@ void wm_x_run_layout() {
   int screen = DefaultScreen(display);
   Window root = wm_x_get_root_window(display);
 
-  unsigned long base_win_items = 0;
-  gf_win_info *base_gf_win_info = NULL;
-
-  // Arrange the first window init
-  int base_workspace_num = wm_x_get_current_workspace(display, root);
-  Window *windows = wm_x_fetch_window_list(
-      display, root, &base_win_items, atoms.client_list, base_workspace_num);
-  if (windows) {
-    base_gf_win_info =
-        (gf_win_info *)malloc(base_win_items * sizeof(gf_win_info));
-    if (base_gf_win_info == NULL) {
-      LOG(GF_WARN, ERR_FAIL_ALLOCATE);
-      free(windows);
-      XCloseDisplay(display);
-      exit(EXIT_FAILURE);
-      return;
-    }
+  if (wm_x_init_planner(display, screen) < 0) {
+    XCloseDisplay(display);
+    exit(EXIT_FAILURE);
+  }
+  if (trace_path)
+    wm_x_start_trace(trace_path);
 
-    for (unsigned long int i = 0; i < base_win_items; i++) {
-      wm_x_unmaximize_window(display, windows[i]);
-      wm_x_arrange_window(base_win_items, windows, display, screen);
-    }
+  char state_path[sizeof(planner.state.path)];
+  if (gf_state_path(state_path, sizeof(state_path)) == 0)
+    gf_state_export_open(&planner.state, state_path);
+  else
+    LOG(GF_INFO, "No usable state file path, layout state is not exported");
 
-    XFree(windows);
+  if (gf_planner_start(&planner) < 0) {
+    gf_planner_free(&planner);
+    XCloseDisplay(display);
+    exit(EXIT_FAILURE);
   }
 
-  unsigned long curr_win_items = 0;
-  XSetErrorHandler(wm_x_error_handler);
-
-  while (1) {
-    int total_workspaces = wm_x_get_total_workspace(display, root);
+  char control_path[sizeof(control.path)];
+  control.listen_fd = -1;
+  if (gf_control_socket_path(control_path, sizeof(control_path)) == 0)
+    gf_control_open(&control, control_path);
+  else
+    LOG(GF_INFO, "No usable control socket path, gridfluxctl is disabled");
 
-    unsigned long total_window = wm_x_get_total_window(display, root);
-    int workspace_need = (int)total_window / MAX_WIN_OPEN;
+  XSetErrorHandler(wm_x_error_handler);
+  XSelectInput(display, root, PropertyChangeMask | SubstructureNotifyMask);
+  wm_x_load_snapshot(display, root, screen);
 
-    if (total_workspaces <= workspace_need) {
-      wm_x_set_workspace(display, root, workspace_need);
-      usleep(20000);
+  // Arrange the first window init
+  gf_planner_post(&planner, &(gf_trace_record){.type = GF_TRACE_MARK_ALL,
+                                               .value = (long)workspace_count});
+  wm_x_post_pass();
+  gf_planner_flush(&planner);
+
+  XEvent event;
+  struct pollfd fds[2 + 1 + GF_CONTROL_MAX_CLIENTS];
+
+  signal(SIGINT, wm_x_stop);
+  signal(SIGTERM, wm_x_stop);
+
+  while (running) {
+    int count = wm_x_wait_for_events(display, fds);
+    if (count < 0)
+      break;
+
+    gf_stats_poll_report();
+    wm_x_apply_actions(display);
+
+    // A cycle is one event batch; the planner copies what it keeps
+    gf_arena_reset(&arena);
+
+    // Coalesce everything already queued, and any commands, into a single
+    // layout pass
+    commanded = 0;
+    gf_control_dispatch(&control, fds + 2, count - 2, wm_x_control, display);
+    if (XPending(display) || commanded) {
+      while (XPending(display)) {
+        XNextEvent(display, &event);
+        wm_x_handle_event(display, root, screen, &event);
+      }
+      wm_x_post_pass();
     }
-
-    wm_x_manage_window(display, root, &base_win_items, base_gf_win_info,
-                       screen);
-    usleep(20000);
+    gf_planner_flush(&planner);
   }
 
+  gf_control_close(&control);
+  gf_planner_stop(&planner);
+  gf_stats_finish();
+  if (planner.pipeline.trace)
+    gf_trace_close(&trace);
+  gf_planner_free(&planner);
+  gf_client_table_free(&clients);
+  gf_arena_free(&arena);
   XCloseDisplay(display);
 }
@@ -29,28 +29,17 @@
 #define HINT_NO_DECORATIONS (1 << 4)
 #define APPLY_PADDING (1 << 5)
 
-#define DEFAULT_PADDING 6
+#define DEFAULT_PADDING GF_LAYOUT_DEFAULT_GAP
 
+#include "layout.h"
 #include <X11/X.h>
 #include <X11/Xatom.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <unistd.h>
 
-typedef struct {
-  Window window;
-  int height;
-  int width;
-} gf_win_info;
-
-typedef struct {
-  int workspace_id;
-  int total_window_open;
-  int available_space;
-} gf_workspace_info;
-
-void wm_x_run_layout();
-void wm_x_set_geometry(Display *display, Window window, int gravity,
-                       unsigned long mask, int x, int y, int width, int height);
+void wm_x_run_layout(const char *trace_path);
+void wm_x_set_geometry(Display *display, Window window, unsigned long mask,
+                       int x, int y, int width, int height);
 
 #endif
@@ -0,0 +1,201 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+// BSP tree maintenance and the size hint solver, without an X server.
+
+#include "layout.h"
+#include "test.h"
+
+static const gf_layout_params bsp = {GF_LAYOUT_BSP, 0, 0.5f};
+static const gf_rect area = {0, 0, 1000, 800};
+
+static int tree_depth(const gf_layout_tree *tree, int node) {
+  int depth = 0;
+  for (; tree->nodes[node].parent; node = tree->nodes[node].parent)
+    depth++;
+  return depth;
+}
+
+static long tiled_area(const gf_rect *rects, unsigned long count) {
+  long covered = 0;
+  for (unsigned long i = 0; i < count; i++)
+    covered += (long)rects[i].width * rects[i].height;
+  return covered;
+}
+
+static void test_tree_insert(void) {
+  gf_layout_tree tree = {0};
+  Window windows[8];
+  gf_rect rects[8];
+
+  for (Window window = 1; window <= 8; window++) {
+    int leaf = gf_layout_tree_insert(&tree, window);
+    GF_CHECK(leaf > 0);
+    GF_CHECK_EQ(tree.nodes[leaf].window, window);
+    GF_CHECK_EQ(tree.nodes[leaf].leaves, 1);
+    GF_CHECK_EQ(tree.nodes[tree.root].leaves, window);
+    // Splitting the side with fewer tiles keeps 8 windows 3 levels deep
+    GF_CHECK(tree_depth(&tree, leaf) <= 3);
+
+    unsigned long count =
+        gf_layout_tree_compute(&bsp, &tree, area, windows, rects);
+    GF_CHECK_EQ(count, window);
+    GF_CHECK_EQ(tiled_area(rects, count), (long)area.width * area.height);
+  }
+  gf_layout_tree_free(&tree);
+
+  // The second window halves the first, the third halves the second
+  for (Window window = 1; window <= 3; window++)
+    gf_layout_tree_insert(&tree, window);
+  GF_CHECK_EQ(gf_layout_tree_compute(&bsp, &tree, area, windows, rects), 3);
+  GF_CHECK_EQ(windows[0], 1);
+  GF_CHECK_RECT(rects[0], 0, 0, 500, 800);
+  GF_CHECK_EQ(windows[1], 2);
+  GF_CHECK_RECT(rects[1], 500, 0, 500, 400);
+  GF_CHECK_EQ(windows[2], 3);
+  GF_CHECK_RECT(rects[2], 500, 400, 500, 400);
+  gf_layout_tree_free(&tree);
+}
+
+static void test_tree_remove(void) {
+  gf_layout_tree tree = {0};
+  Window windows[4];
+  gf_rect rects[4];
+  int leaves[4];
+
+  for (int i = 1; i <= 3; i++)
+    leaves[i] = gf_layout_tree_insert(&tree, (Window)i);
+  int capacity = tree.capacity;
+
+  // The sibling grows into the split; the other half does not move
+  gf_layout_tree_remove(&tree, leaves[2]);
+  GF_CHECK_EQ(tree.nodes[tree.root].leaves, 2);
+  GF_CHECK_EQ(gf_layout_tree_compute(&bsp, &tree, area, windows, rects), 2);
+  GF_CHECK_EQ(windows[0], 1);
+  GF_CHECK_RECT(rects[0], 0, 0, 500, 800);
+  GF_CHECK_EQ(windows[1], 3);
+  GF_CHECK_RECT(rects[1], 500, 0, 500, 800);
+
+  // A leaf that is already gone, or never was one, changes nothing
+  gf_layout_tree_remove(&tree, leaves[2]);
+  gf_layout_tree_remove(&tree, tree.root);
+  gf_layout_tree_remove(&tree, 0);
+  gf_layout_tree_remove(&tree, tree.capacity);
+  GF_CHECK_EQ(tree.nodes[tree.root].leaves, 2);
+
+  gf_layout_tree_remove(&tree, leaves[1]);
+  GF_CHECK_EQ(tree.root, leaves[3]);
+  GF_CHECK_EQ(tree.nodes[tree.root].parent, 0);
+  GF_CHECK_EQ(gf_layout_tree_compute(&bsp, &tree, area, windows, rects), 1);
+  GF_CHECK_RECT(rects[0], 0, 0, 1000, 800);
+
+  gf_layout_tree_remove(&tree, leaves[3]);
+  GF_CHECK_EQ(tree.root, 0);
+  GF_CHECK_EQ(gf_layout_tree_compute(&bsp, &tree, area, windows, rects), 0);
+
+  // Freed nodes are reused before the tree grows
+  for (int i = 1; i <= 3; i++)
+    GF_CHECK(gf_layout_tree_insert(&tree, (Window)i) > 0);
+  GF_CHECK_EQ(tree.capacity, capacity);
+  gf_layout_tree_free(&tree);
+}
+
+static void test_tree_resize(void) {
+  gf_layout_tree tree = {0};
+  Window windows[3], subtree_windows[3];
+  gf_rect rects[3], subtree_rects[3];
+  int leaves[4];
+
+  for (int i = 1; i <= 3; i++)
+    leaves[i] = gf_layout_tree_insert(&tree, (Window)i);
+
+  // Dragging the right edge of window 1 moves the root split
+  int split = gf_layout_tree_resize(&bsp, &tree, area, leaves[1], 100, 0, 0, 0);
+  GF_CHECK_EQ(split, tree.root);
+  gf_layout_tree_compute(&bsp, &tree, area, windows, rects);
+  GF_CHECK_RECT(rects[0], 0, 0, 600, 800);
+  GF_CHECK_RECT(rects[1], 600, 0, 400, 400);
+
+  // The bottom edge of window 2 belongs to the split it shares with 3,
+  // and only that split's tiles have to be placed again
+  split = gf_layout_tree_resize(&bsp, &tree, area, leaves[2], 0, 100, 0, 0);
+  GF_CHECK_EQ(split, tree.nodes[leaves[2]].parent);
+  GF_CHECK_EQ(gf_layout_tree_compute_node(&bsp, &tree, area, split,
+                                          subtree_windows, subtree_rects),
+              2);
+  gf_layout_tree_compute(&bsp, &tree, area, windows, rects);
+  GF_CHECK_RECT(rects[1], 600, 0, 400, 500);
+  GF_CHECK_RECT(rects[2], 600, 500, 400, 300);
+  for (int i = 0; i < 2; i++) {
+    GF_CHECK_EQ(subtree_windows[i], windows[i + 1]);
+    GF_CHECK(gf_rect_equal(subtree_rects[i], rects[i + 1]));
+  }
+
+  // A lone window has no split to move
+  gf_layout_tree_free(&tree);
+  int leaf = gf_layout_tree_insert(&tree, 1);
+  GF_CHECK_EQ(gf_layout_tree_resize(&bsp, &tree, area, leaf, 50, 50, 0, 0), 0);
+  gf_layout_tree_free(&tree);
+}
+
+static void test_hint_snapping(void) {
+  // A terminal: 3 + 9k pixels wide and 5 + 9k high, at most 40 wide
+  gf_size_hints terminal = {.base_width = 3, .base_height = 5,
+                            .width_inc = 9, .height_inc = 9};
+
+  GF_CHECK_EQ(gf_size_hints_fit(&terminal, 0, 500), 498);
+  GF_CHECK_EQ(gf_size_hints_fit(&terminal, 1, 800), 797);
+  GF_CHECK_EQ(gf_size_hints_fit(&terminal, 0, 21), 21);
+  GF_CHECK_EQ(gf_size_hints_fit(&terminal, 0, 2), 2);
+  GF_CHECK_EQ(gf_size_hints_fit(NULL, 0, 500), 500);
+
+  terminal.max_width = 40;
+  GF_CHECK_EQ(gf_size_hints_fit(&terminal, 0, 500), 39);
+  terminal.max_width = 0;
+
+  terminal.min_width = 100;
+  GF_CHECK_EQ(gf_size_hints_fit(&terminal, 0, 50), 100);
+  terminal.min_width = 0;
+
+  // The snapped window gives what it cannot use to its sibling
+  gf_size_hints hints[2] = {terminal, {0}};
+  gf_rect rects[2];
+  gf_layout_compute(&bsp, 2, area, hints, rects);
+  GF_CHECK_RECT(rects[0], 0, 0, 498, 797);
+  GF_CHECK_RECT(rects[1], 498, 0, 502, 800);
+
+  // Same through a persistent tree
+  gf_layout_tree tree = {0};
+  Window windows[2];
+  int leaf = gf_layout_tree_insert(&tree, 1);
+  gf_layout_tree_insert(&tree, 2);
+  tree.nodes[leaf].hints = terminal;
+  gf_layout_tree_compute(&bsp, &tree, area, windows, rects);
+  GF_CHECK_RECT(rects[0], 0, 0, 498, 797);
+  GF_CHECK_RECT(rects[1], 498, 0, 502, 800);
+  gf_layout_tree_free(&tree);
+}
+
+int main(void) {
+  test_tree_insert();
+  test_tree_remove();
+  test_tree_resize();
+  test_hint_snapping();
+  return gf_test_result("layout_test");
+}
@@ -0,0 +1,153 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+// The lock-free handoffs between threads: the SPSC ring the X and planner
+// threads talk through and the seqlocked state export.
+
+#include "spsc.h"
+#include "state.h"
+#include "test.h"
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+#define STATE_PATH "queue_test.state"
+#define STRESS_ITEMS 200000UL
+
+static int readable(int fd) {
+  struct pollfd pfd = {.fd = fd, .events = POLLIN};
+  return poll(&pfd, 1, 0) == 1;
+}
+
+static void test_spsc_backlog(void) {
+  gf_spsc queue;
+  unsigned long item;
+  GF_CHECK_EQ(gf_spsc_init(&queue, sizeof(item), 16), 0);
+
+  // Pushed items stay unannounced until the producer publishes them
+  for (item = 0; item < 40; item++)
+    GF_CHECK_EQ(gf_spsc_push(&queue, &item), 0);
+  GF_CHECK(!readable(gf_spsc_fd(&queue)));
+  GF_CHECK_EQ(gf_spsc_publish(&queue), 40 - 16);
+  GF_CHECK(readable(gf_spsc_fd(&queue)));
+
+  // The ring holds 16; the rest follow in order as the consumer drains
+  unsigned long expected = 0;
+  for (int round = 0; round < 4; round++) {
+    gf_spsc_clear(&queue);
+    GF_CHECK(!readable(gf_spsc_fd(&queue)));
+    while (gf_spsc_pop(&queue, &item)) {
+      GF_CHECK_EQ(item, expected);
+      expected++;
+    }
+    gf_spsc_publish(&queue);
+  }
+  GF_CHECK_EQ(expected, 40);
+  GF_CHECK_EQ(gf_spsc_pop(&queue, &item), 0);
+  gf_spsc_free(&queue);
+}
+
+static void *spsc_producer(void *arg) {
+  gf_spsc *queue = arg;
+  for (unsigned long item = 0; item < STRESS_ITEMS; item++) {
+    gf_spsc_push(queue, &item);
+    if (item % 64 == 0)
+      gf_spsc_publish(queue);
+  }
+  while (gf_spsc_publish(queue))
+    sched_yield();
+  return NULL;
+}
+
+static void test_spsc_threads(void) {
+  gf_spsc queue;
+  pthread_t producer;
+  GF_CHECK_EQ(gf_spsc_init(&queue, sizeof(unsigned long), 256), 0);
+  GF_CHECK_EQ(pthread_create(&producer, NULL, spsc_producer, &queue), 0);
+
+  unsigned long expected = 0, item;
+  int ordered = 1;
+  struct pollfd pfd = {.fd = gf_spsc_fd(&queue), .events = POLLIN};
+  while (expected < STRESS_ITEMS) {
+    poll(&pfd, 1, 100);
+    gf_spsc_clear(&queue);
+    while (gf_spsc_pop(&queue, &item)) {
+      ordered &= item == expected;
+      expected++;
+    }
+  }
+  GF_CHECK(ordered);
+  GF_CHECK_EQ(expected, STRESS_ITEMS);
+
+  pthread_join(producer, NULL);
+  gf_spsc_free(&queue);
+}
+
+static void test_state_seqlock(void) {
+  gf_state_export export;
+  gf_state copy;
+
+  unlink(STATE_PATH);
+  GF_CHECK_EQ(gf_state_export_open(&export, STATE_PATH), 0);
+  if (!export.state)
+    return;
+
+  const gf_state *mapped = gf_state_map(STATE_PATH);
+  GF_CHECK(mapped != NULL);
+  if (!mapped) {
+    gf_state_export_close(&export);
+    return;
+  }
+
+  GF_CHECK_EQ(gf_state_read(mapped, &copy), 0);
+  GF_CHECK_EQ(copy.windows, 0);
+
+  gf_state *state = gf_state_begin(&export);
+  state->windows = 3;
+  state->tile_count = 1;
+  state->tiles[0] = (gf_state_tile){0x400001, 0, 0, 6, 6, 948, 528};
+  gf_state_end(&export);
+
+  GF_CHECK_EQ(gf_state_read(mapped, &copy), 0);
+  GF_CHECK_EQ(copy.sequence % 2, 0);
+  GF_CHECK_EQ(copy.windows, 3);
+  GF_CHECK_EQ(copy.tiles[0].window, 0x400001);
+  GF_CHECK_EQ(copy.tiles[0].width, 948);
+
+  // A writer stuck halfway never hands out a torn copy
+  state = gf_state_begin(&export);
+  state->windows = 4;
+  GF_CHECK_EQ(gf_state_read(mapped, &copy), -1);
+  gf_state_end(&export);
+  GF_CHECK_EQ(gf_state_read(mapped, &copy), 0);
+  GF_CHECK_EQ(copy.windows, 4);
+
+  gf_state_unmap(mapped);
+  gf_state_export_close(&export);
+  GF_CHECK(access(STATE_PATH, F_OK) != 0);
+}
+
+int main(void) {
+  test_spsc_backlog();
+  test_spsc_threads();
+  test_state_seqlock();
+  return gf_test_result("queue_test");
+}
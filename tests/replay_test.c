@@ -0,0 +1,187 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+// Records a short session through the pipeline calls the planner makes,
+// replays the trace and checks the decisions the replay prints: the ones
+// the session took, in the same order.
+
+#include "pipeline.h"
+#include "test.h"
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_PATH "replay_test.gft"
+
+static const char *expected[] = {
+    // Three windows, two tiles per workspace: the last one moves on
+    "  unmaximize window=0x3",
+    "  move window=0x3 workspace=1",
+    "  unmaximize window=0x1",
+    "  unmaximize window=0x2",
+    "  configure window=0x1 x=6 y=6 width=488 height=788",
+    "  configure window=0x2 x=506 y=6 width=488 height=788",
+    "  unmaximize window=0x3",
+    "  configure window=0x3 x=8 y=26 width=984 height=766",
+    // Dragging the edge between 1 and 2 moves only those two
+    "  configure window=0x1 x=6 y=6 width=588 height=788",
+    "  configure window=0x2 x=606 y=6 width=388 height=788",
+    // Closing 2 hands its tile to 1
+    "  configure window=0x1 x=6 y=6 width=988 height=788",
+    // Shrunk while paused: nothing until the pass after the resume
+    "  unmaximize window=0x1",
+    "  configure window=0x1 x=6 y=6 width=988 height=788",
+};
+
+#define EXPECTED_COUNT (sizeof(expected) / sizeof(expected[0]))
+
+static void session_unmaximize(void *user_data, Window window) {
+  fprintf(user_data, "  unmaximize window=0x%lx\n", window);
+}
+
+static void session_move(void *user_data, Window window, long workspace) {
+  fprintf(user_data, "  move window=0x%lx workspace=%ld\n", window,
+          workspace);
+}
+
+static void session_configure(void *user_data, Window window, gf_rect rect) {
+  fprintf(user_data, "  configure window=0x%lx x=%d y=%d width=%d height=%d\n",
+          window, rect.x, rect.y, rect.width, rect.height);
+}
+
+static int session_request(void *user_data, unsigned long current,
+                           unsigned long wanted) {
+  fprintf(user_data, "  workspaces current=%lu wanted=%lu\n", current, wanted);
+  return 0;
+}
+
+static void session_client(gf_pipeline *pipeline, Window window, long desktop,
+                           gf_frame_extents frame) {
+  gf_pipeline_apply(pipeline, &(gf_trace_record){
+                                  .type = GF_TRACE_CLIENT,
+                                  .window = window,
+                                  .value = desktop,
+                                  .rect = {100, 100, 300, 200},
+                                  .frame = frame,
+                              });
+}
+
+// Drives the pipeline like the planner thread would, recording as it goes
+static int record_session(FILE *decisions) {
+  gf_trace trace;
+  gf_trace_header header = {.area = {0, 0, 1000, 800}, .max_windows = 2};
+  if (gf_trace_open_write(&trace, TRACE_PATH, &header) < 0)
+    return -1;
+
+  gf_pipeline_backend backend = {session_unmaximize, session_move,
+                                 session_configure, decisions};
+  gf_workspace_backend workspaces = {"test", session_request, decisions};
+  gf_pipeline pipeline;
+  if (gf_pipeline_init(&pipeline, backend, workspaces, header.area, NULL) <
+      0) {
+    gf_trace_close(&trace);
+    return -1;
+  }
+  pipeline.max_windows = header.max_windows;
+  pipeline.trace = &trace;
+
+  const Window windows[] = {0x1, 0x2, 0x3};
+  gf_pipeline_sync_clients(&pipeline, windows, 3);
+  session_client(&pipeline, 0x1, 0, (gf_frame_extents){0});
+  session_client(&pipeline, 0x2, 0, (gf_frame_extents){0});
+  session_client(&pipeline, 0x3, 0, (gf_frame_extents){2, 2, 20, 2});
+  gf_pipeline_run(&pipeline, 2);
+
+  // The move lands on workspace 1, which the next pass lays out
+  session_client(&pipeline, 0x3, 1, (gf_frame_extents){2, 2, 20, 2});
+  gf_pipeline_run(&pipeline, 2);
+
+  // The server echoes our configures, then the user widens window 1 by 100
+  // pixels from its right edge
+  gf_pipeline_configure(&pipeline, 0x1, (gf_rect){6, 6, 488, 788});
+  gf_pipeline_configure(&pipeline, 0x2, (gf_rect){506, 6, 488, 788});
+  gf_pipeline_configure(&pipeline, 0x1, (gf_rect){6, 6, 588, 788});
+  gf_pipeline_run(&pipeline, 2);
+
+  gf_pipeline_destroy(&pipeline, 0x2);
+  gf_pipeline_run(&pipeline, 2);
+
+  gf_pipeline_configure(&pipeline, 0x1, (gf_rect){6, 6, 988, 788});
+  gf_pipeline_pause(&pipeline, 1);
+  gf_pipeline_configure(&pipeline, 0x1, (gf_rect){6, 6, 400, 300});
+  gf_pipeline_run(&pipeline, 2);
+  gf_pipeline_pause(&pipeline, 0);
+  gf_pipeline_run(&pipeline, 2);
+
+  gf_pipeline_free(&pipeline);
+  gf_trace_close(&trace);
+  return 0;
+}
+
+// Leaves only the decision lines of a session or replay log in `lines`
+static unsigned long read_decisions(FILE *file, char lines[][128],
+                                    unsigned long capacity) {
+  char line[128];
+  unsigned long count = 0;
+
+  rewind(file);
+  while (fgets(line, sizeof(line), file)) {
+    if (strncmp(line, "  ", 2) != 0)
+      continue;
+    line[strcspn(line, "\n")] = '\0';
+    if (count < capacity)
+      memcpy(lines[count], line, sizeof(line));
+    count++;
+  }
+  return count;
+}
+
+int main(void) {
+  char session_lines[32][128], replay_lines[32][128];
+  FILE *session = tmpfile();
+  FILE *replay = tmpfile();
+  GF_CHECK(session && replay);
+  if (!session || !replay)
+    return gf_test_result("replay_test");
+
+  GF_CHECK_EQ(record_session(session), 0);
+  GF_CHECK_EQ(gf_pipeline_replay(TRACE_PATH, replay), 0);
+  unlink(TRACE_PATH);
+
+  unsigned long recorded = read_decisions(session, session_lines, 32);
+  unsigned long replayed = read_decisions(replay, replay_lines, 32);
+  GF_CHECK_EQ(recorded, EXPECTED_COUNT);
+  GF_CHECK_EQ(replayed, EXPECTED_COUNT);
+
+  for (unsigned long i = 0; i < EXPECTED_COUNT; i++) {
+    if (i < recorded && strcmp(session_lines[i], expected[i]) != 0) {
+      fprintf(stderr, "session decision %lu: \"%s\", expected \"%s\"\n", i,
+              session_lines[i], expected[i]);
+      gf_test_failures++;
+    }
+    if (i < replayed && strcmp(replay_lines[i], expected[i]) != 0) {
+      fprintf(stderr, "replayed decision %lu: \"%s\", expected \"%s\"\n", i,
+              replay_lines[i], expected[i]);
+      gf_test_failures++;
+    }
+  }
+
+  fclose(session);
+  fclose(replay);
+  return gf_test_result("replay_test");
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+#ifndef GF_TEST
+#define GF_TEST
+
+#include <stdio.h>
+
+// Checks for the headless tests: a failure prints where it happened and
+// the test carries on, so one run reports every broken expectation.
+static int gf_test_failures;
+
+#define GF_CHECK(condition)                                                    \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,         \
+              #condition);                                                     \
+      gf_test_failures++;                                                      \
+    }                                                                          \
+  } while (0)
+
+#define GF_CHECK_EQ(actual, expected)                                          \
+  do {                                                                         \
+    long long actual_ = (long long)(actual);                                   \
+    long long expected_ = (long long)(expected);                               \
+    if (actual_ != expected_) {                                                \
+      fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__,          \
+              __LINE__, #actual, actual_, expected_);                          \
+      gf_test_failures++;                                                      \
+    }                                                                          \
+  } while (0)
+
+#define GF_CHECK_RECT(actual, x_, y_, width_, height_)                         \
+  do {                                                                         \
+    gf_rect rect_ = (actual);                                                  \
+    if (rect_.x != (x_) || rect_.y != (y_) || rect_.width != (width_) ||       \
+        rect_.height != (height_)) {                                           \
+      fprintf(stderr, "%s:%d: %s is %d,%d %dx%d, expected %d,%d %dx%d\n",      \
+              __FILE__, __LINE__, #actual, rect_.x, rect_.y, rect_.width,      \
+              rect_.height, (x_), (y_), (width_), (height_));                  \
+      gf_test_failures++;                                                      \
+    }                                                                          \
+  } while (0)
+
+static int gf_test_result(const char *name) {
+  if (gf_test_failures)
+    fprintf(stderr, "%s: %d checks failed\n", name, gf_test_failures);
+  return gf_test_failures ? 1 : 0;
+}
+
+#endif // GF_TEST
@@ -0,0 +1,142 @@
+/*
+ * This file is part of gridflux.
+ *
+ * gridflux is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * gridflux is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with gridflux.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2025 Ardinugraha
+ */
+
+// Writes every record type with values around the varint byte boundaries
+// and reads them back.
+
+#include "test.h"
+#include "trace.h"
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACE_PATH "trace_test.gft"
+
+static Window windows[] = {0x0, 0x7f, 0x80, 0x3fff, 0x4000, 0x1e00007,
+                           0xffffffffUL};
+static gf_rect outputs[] = {{0, 0, 1920, 1080}, {-1280, -64, 1280, 1024}};
+
+// Zigzag maps these to the largest one and two byte varints and just past
+static const long values[] = {0,    -1,    63,      -64,     64,
+                              8191, -8192, 8192,    1L << 40, -(1L << 40),
+                              LONG_MAX, LONG_MIN};
+
+#define VALUE_COUNT (sizeof(values) / sizeof(values[0]))
+#define WINDOW_COUNT (sizeof(windows) / sizeof(windows[0]))
+
+static gf_trace_record records[] = {
+    {.type = GF_TRACE_OUTPUTS, .rects = outputs, .count = 2},
+    {.type = GF_TRACE_CLIENT_LIST, .windows = windows, .count = WINDOW_COUNT},
+    {.type = GF_TRACE_CLIENT_LIST, .windows = windows, .count = 0},
+    {.type = GF_TRACE_CLIENT,
+     .window = 0x1e00007,
+     .value = GF_DESKTOP_UNKNOWN,
+     .flags = GF_CLIENT_FETCHED,
+     .rect = {-5, -30, 640, 480}},
+    {.type = GF_TRACE_HINTS,
+     .window = 0x1e00007,
+     .hints = {10, 20, 3000, 2000, 4, 5, 9, 17, 10}},
+    {.type = GF_TRACE_FRAME, .window = 0x1e00007, .frame = {2, 2, 30, -8}},
+    {.type = GF_TRACE_CONFIGURE, .window = 0x80, .rect = {6, 6, 948, 528}},
+    {.type = GF_TRACE_SYNC, .window = 0x4000},
+    {.type = GF_TRACE_DESTROY, .window = 0xffffffffUL},
+    {.type = GF_TRACE_LAYOUT, .value = 3, .flags = GF_LAYOUT_GRID},
+    {.type = GF_TRACE_RELAYOUT, .value = -1},
+    {.type = GF_TRACE_CAPACITY, .value = 0},
+    {.type = GF_TRACE_PAUSE, .value = 1},
+    {.type = GF_TRACE_MARK_ALL, .value = 4},
+};
+
+#define RECORD_COUNT (sizeof(records) / sizeof(records[0]))
+
+static void check_record(const gf_trace_record *read,
+                         const gf_trace_record *written) {
+  GF_CHECK_EQ(read->type, written->type);
+  GF_CHECK_EQ(read->window, written->window);
+  GF_CHECK_EQ(read->value, written->value);
+  GF_CHECK_EQ(read->flags, written->flags);
+  GF_CHECK(gf_rect_equal(read->rect, written->rect));
+  GF_CHECK(memcmp(&read->hints, &written->hints, sizeof(read->hints)) == 0);
+  GF_CHECK(memcmp(&read->frame, &written->frame, sizeof(read->frame)) == 0);
+  GF_CHECK_EQ(read->count, written->count);
+
+  for (unsigned long i = 0; i < read->count; i++) {
+    if (written->windows)
+      GF_CHECK_EQ(read->windows[i], written->windows[i]);
+    if (written->rects)
+      GF_CHECK(gf_rect_equal(read->rects[i], written->rects[i]));
+  }
+}
+
+int main(void) {
+  gf_trace trace;
+  gf_trace_header header = {.area = {0, 24, 2560, 1416}, .max_windows = 6};
+  snprintf(header.layouts, sizeof(header.layouts), "0:bsp,1:grid");
+
+  GF_CHECK_EQ(gf_trace_open_write(&trace, TRACE_PATH, &header), 0);
+  for (unsigned long i = 0; i < RECORD_COUNT; i++)
+    GF_CHECK_EQ(gf_trace_write(&trace, &records[i]), 0);
+  for (unsigned long i = 0; i < VALUE_COUNT; i++)
+    GF_CHECK_EQ(gf_trace_write(&trace, &(gf_trace_record){
+                                           .type = GF_TRACE_MARK,
+                                           .value = values[i]}),
+                0);
+  gf_trace_close(&trace);
+
+  gf_trace_header read_header;
+  gf_trace_record record;
+  unsigned long long last_us = 0;
+  GF_CHECK_EQ(gf_trace_open_read(&trace, TRACE_PATH, &read_header), 0);
+  GF_CHECK(gf_rect_equal(read_header.area, header.area));
+  GF_CHECK_EQ(read_header.max_windows, header.max_windows);
+  GF_CHECK(strcmp(read_header.layouts, header.layouts) == 0);
+
+  for (unsigned long i = 0; i < RECORD_COUNT; i++) {
+    GF_CHECK_EQ(gf_trace_read(&trace, &record), 1);
+    check_record(&record, &records[i]);
+    GF_CHECK(record.time_us >= last_us);
+    last_us = record.time_us;
+  }
+  for (unsigned long i = 0; i < VALUE_COUNT; i++) {
+    GF_CHECK_EQ(gf_trace_read(&trace, &record), 1);
+    GF_CHECK_EQ(record.type, GF_TRACE_MARK);
+    GF_CHECK_EQ(record.value, values[i]);
+  }
+  GF_CHECK_EQ(gf_trace_read(&trace, &record), 0);
+  gf_trace_close(&trace);
+
+  // A record cut short is an error, not the end of the trace
+  FILE *file = fopen(TRACE_PATH, "r+b");
+  GF_CHECK(file != NULL);
+  if (file) {
+    fseek(file, -1, SEEK_END);
+    GF_CHECK_EQ(ftruncate(fileno(file), ftell(file)), 0);
+    fclose(file);
+
+    GF_CHECK_EQ(gf_trace_open_read(&trace, TRACE_PATH, &read_header), 0);
+    int status;
+    while ((status = gf_trace_read(&trace, &record)) > 0)
+      ;
+    GF_CHECK_EQ(status, -1);
+    gf_trace_close(&trace);
+  }
+
+  unlink(TRACE_PATH);
+  return gf_test_result("trace_test");
+}
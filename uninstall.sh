@@ -9,7 +9,7 @@ SERVICE_FILE="/etc/systemd/system/gridflux.service"
 remove_binary() {
   echo "Removing gridflux binary from $INSTALL_DIR..."
   if [ -f "$INSTALL_DIR/gridflux" ]; then
-    sudo rm -f "$INSTALL_DIR/gridflux"
+    sudo rm -f "$INSTALL_DIR/gridflux" "$INSTALL_DIR/gridfluxctl"
     echo "Binary removed successfully."
   else
     echo "Binary not found at $INSTALL_DIR. Skipping."